@@ -15,6 +15,8 @@ in the sequence.
 #include <string.h>
 
 #include "block.h"
+#include "hex.h"
+#include "prng.h"
 
 /* creates and returns new block with MS as most significant 32 digits
  and LS as least significant 32 digits. MS and LS need  to be unsigned
@@ -27,46 +29,38 @@ block_t block_new(unsigned int MS, unsigned int LS) {
 
 /* creates new block from random values */
 block_t block_newRandom() {
-    block_t oBlock = {.MS = rand(), .LS = rand()};
+    block_t oBlock;
 
+    block_getRandom(&oBlock);
     return oBlock;
 }
 
-/* get int from char */
-static int getInt(char c) {
-    if (c >= '0' && c <= '9') {
-        return c - '0';
-    } else if (c >='a' && c <= 'f') {
-        return c - 'a' + 10;
-    } else if (c >= 'A' && c <= 'F') {
-        return c - 'A' + 10;
+/* parses a 16 character hex string into block. Returns 0 if no error */
+int block_fromString(const char* blockString, block_t* block) {
+    uint64_t value;
+
+    assert(blockString != NULL && block != NULL);
+
+    if (strlen(blockString) != NUM_OF_NIBBLES ||
+        hex_decode64(blockString, &value) != 0) {
+        return -1; /* error */
     }
 
-    fprintf(stderr, "getInt: invalid character! must be 0-9 or a-f\n");
-    exit(-1);
+    *block = block_new(value >> 32, (uint32_t) value);
+    return 0;
 }
 
 /* creates new block from string */
 block_t block_newFromString(char blockString[NUM_OF_NIBBLES + 1]) {
-    unsigned int value[2];
-
-    int valueIndex;
-    int placeIndex;
-    int stringIndex = 0;
+    block_t oBlock;
 
-    assert(strlen(blockString) == NUM_OF_NIBBLES);
-
-    for (valueIndex = 0; valueIndex < 2; valueIndex++) {
-        value[valueIndex] = 0;
-        for (placeIndex = 7; placeIndex >= 0; placeIndex--) {
-            int num = getInt(blockString[stringIndex]);
-            value[valueIndex] +=  (((unsigned int)num) << 4 * placeIndex);
-
-            stringIndex++;
-        }
+    if (block_fromString(blockString, &oBlock) != 0) {
+        fprintf(stderr, "block_newFromString: invalid block! must be %d hex digits\n",
+                NUM_OF_NIBBLES);
+        exit(-1);
     }
 
-    return block_new(value[0], value[1]);
+    return oBlock;
 }
 
 
@@ -139,8 +133,10 @@ int block_setNibble(block_t* block, int index, int nibble) {
 void block_getRandom(block_t* block) {
     assert(block != NULL);
 
-    block->MS = rand();
-    block->LS = rand();
+    uint64_t value = prng_next(prng_thread());
+
+    block->MS = value >> 32;
+    block->LS = (uint32_t) value;
 }
 
 /* prints block */
@@ -150,5 +146,6 @@ void block_print(block_t block) {
 
 /* sets str to block expressed in hex*/
 void block_toString(block_t block, char str[NUM_OF_NIBBLES + 1]) {
-    sprintf(str, "%08x%08x", block.MS, block.LS);
+    hex_encode64(((uint64_t) block.MS << 32) | block.LS, str);
+    str[NUM_OF_NIBBLES] = '\0';
 }
@@ -31,7 +31,10 @@ block_t block_new(unsigned int MS, unsigned int LS);
 /* creates new block from random values */
 block_t block_newRandom();
 
-/* creates new block from string */
+/* parses a 16 character hex string into block. Returns 0 if no error */
+int block_fromString(const char* blockString, block_t* block);
+
+/* creates new block from string, exits on an invalid string */
 block_t block_newFromString(char blockString[NUM_OF_NIBBLES + 1]);
 
 /* sets the value of block so that MS is first 32 bits
@@ -0,0 +1,151 @@
+/**
+hex.c
+
+Implementation of the hex codec used for blocks and keys
+
+On x86-64 CPUs with SSSE3 a value is decoded with one compare per digit
+class over all 16 characters and a pmaddubsw/packuswb to merge nibbles, and
+encoded with one pshufb. Otherwise a scalar loop is used. The choice is
+made once at startup.
+**/
+
+#include "hex.h"
+
+#if defined(__x86_64__)
+#define HEX_HAVE_SSSE3 1
+#include <immintrin.h>
+#else
+#define HEX_HAVE_SSSE3 0
+#endif
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* returns the value of a hex digit, or -1 */
+static inline int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+static int hex_decode64Scalar(const char str[HEX_DIGITS], uint64_t* value) {
+    uint64_t v = 0;
+
+    for (int i = 0; i < HEX_DIGITS; i++) {
+        int nibble = hex_value(str[i]);
+        if (nibble < 0) {
+            return -1; /* error */
+        }
+        v = (v << 4) | nibble;
+    }
+
+    *value = v;
+    return 0;
+}
+
+static void hex_encode64Scalar(uint64_t value, char str[HEX_DIGITS]) {
+    for (int i = HEX_DIGITS - 1; i >= 0; i--) {
+        str[i] = hex_digits[value & 0xf];
+        value >>= 4;
+    }
+}
+
+#if HEX_HAVE_SSSE3
+__attribute__((target("ssse3")))
+static int hex_decode64Ssse3(const char str[HEX_DIGITS], uint64_t* value) {
+    __m128i c = _mm_loadu_si128((const __m128i*) str);
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+
+    /* signed compares, so bytes >= 0x80 fail both tests */
+    __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                    _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                    _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xffff) {
+        return -1; /* error */
+    }
+
+    __m128i nibbles = _mm_or_si128(
+        _mm_and_si128(isDigit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+        _mm_andnot_si128(isDigit, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+
+    /* 16 * first + second digit of every pair, then one byte per pair */
+    __m128i bytes = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+    bytes = _mm_packus_epi16(bytes, bytes);
+
+    *value = __builtin_bswap64(_mm_cvtsi128_si64(bytes));
+    return 0;
+}
+
+__attribute__((target("ssse3")))
+static void hex_encode64Ssse3(uint64_t value, char str[HEX_DIGITS]) {
+    __m128i bytes = _mm_cvtsi64_si128(__builtin_bswap64(value));
+    __m128i mask = _mm_set1_epi8(0x0f);
+
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+    __m128i lo = _mm_and_si128(bytes, mask);
+    __m128i nibbles = _mm_unpacklo_epi8(hi, lo);
+
+    __m128i digits = _mm_loadu_si128((const __m128i*) hex_digits);
+    _mm_storeu_si128((__m128i*) str, _mm_shuffle_epi8(digits, nibbles));
+}
+#endif
+
+static int (*hex_decode64Impl)(const char str[HEX_DIGITS], uint64_t* value) = hex_decode64Scalar;
+static void (*hex_encode64Impl)(uint64_t value, char str[HEX_DIGITS]) = hex_encode64Scalar;
+
+__attribute__((constructor))
+static void hex_init(void) {
+#if HEX_HAVE_SSSE3
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        hex_decode64Impl = hex_decode64Ssse3;
+        hex_encode64Impl = hex_encode64Ssse3;
+    }
+#endif
+}
+
+int hex_decode64(const char str[HEX_DIGITS], uint64_t* value) {
+    return hex_decode64Impl(str, value);
+}
+
+int hex_parse(const char* str, size_t len, uint64_t* value) {
+    if (len == HEX_DIGITS) {
+        return hex_decode64Impl(str, value);
+    }
+
+    if (len == 0 || len > HEX_DIGITS) {
+        return -1; /* error */
+    }
+
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        int nibble = hex_value(str[i]);
+        if (nibble < 0) {
+            return -1; /* error */
+        }
+        v = (v << 4) | nibble;
+    }
+
+    *value = v;
+    return 0;
+}
+
+void hex_encode64(uint64_t value, char str[HEX_DIGITS]) {
+    hex_encode64Impl(value, str);
+}
+
+size_t hex_encodeLines(const uint64_t* values, size_t n, char* str) {
+    for (size_t i = 0; i < n; i++) {
+        hex_encode64Impl(values[i], str + i * (HEX_DIGITS + 1));
+        str[i * (HEX_DIGITS + 1) + HEX_DIGITS] = '\n';
+    }
+
+    return n * (HEX_DIGITS + 1);
+}
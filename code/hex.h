@@ -0,0 +1,33 @@
+/**
+hex.h
+
+Interface for the hex codec used for blocks and keys
+
+16 hex digits are the 64-bit value most significant nibble first, as
+printed by "%016lx". Decoding accepts upper and lower case, encoding
+writes lower case. No function writes a terminating '\0'.
+**/
+
+#ifndef _HEX_INCLUDED_
+#define _HEX_INCLUDED_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+/* hex digits of a 64-bit value */
+enum{HEX_DIGITS = 16};
+
+/* parses exactly 16 hex digits. Returns 0 if no error */
+int hex_decode64(const char str[HEX_DIGITS], uint64_t* value);
+
+/* parses 1 to 16 hex digits. Returns 0 if no error */
+int hex_parse(const char* str, size_t len, uint64_t* value);
+
+/* writes value as 16 hex digits */
+void hex_encode64(uint64_t value, char str[HEX_DIGITS]);
+
+/* writes every value as 16 hex digits and a newline, returns the number of
+   bytes written, which is n * (HEX_DIGITS + 1) */
+size_t hex_encodeLines(const uint64_t* values, size_t n, char* str);
+
+#endif
@@ -10,6 +10,7 @@ Implementation for expanded key used by PRINCEv2 cipher
 #include <stdlib.h>
 #include <string.h>
 
+#include "hex.h"
 #include "key.h"
 #include "misc.h"
 
@@ -44,26 +45,33 @@ princev2key_t key_newRandom() {
     return key_new(llrand(), llrand());
 }
 
-/* creates new princev2key_t from 48 character string */
-princev2key_t key_newFromString(char keyString[KEY_HEX_LENGTH + 1]) {
-    uint64_t value[2];
+/* parses a 32 character hex string into key. Returns 0 if no error */
+int key_fromString(const char* keyString, princev2key_t* key) {
+    uint64_t k0, k1;
+
+    assert(keyString != NULL && key != NULL);
 
-    int valueIndex;
-    int placeIndex;
-    int stringIndex = 0;
+    if (strlen(keyString) != KEY_HEX_LENGTH ||
+        hex_decode64(keyString, &k0) != 0 ||
+        hex_decode64(keyString + HEX_DIGITS, &k1) != 0) {
+        return -1; /* error */
+    }
 
-    assert(strlen(keyString) == KEY_HEX_LENGTH);
+    *key = key_new(k0, k1);
+    return 0;
+}
 
-    for (valueIndex = 0; valueIndex < 2; valueIndex++) {
-        value[valueIndex] = 0;
-        for (placeIndex = 15; placeIndex >= 0; placeIndex--) {
-            uint64_t num = (uint64_t) getInt(keyString[stringIndex]);
-            value[valueIndex] +=  (num << 4*placeIndex);
-            stringIndex++;
-        }
+/* creates new princev2key_t from 32 character string */
+princev2key_t key_newFromString(char keyString[KEY_HEX_LENGTH + 1]) {
+    princev2key_t oKey;
+
+    if (key_fromString(keyString, &oKey) != 0) {
+        fprintf(stderr, "key_newFromString: invalid key! must be %d hex digits\n",
+                KEY_HEX_LENGTH);
+        exit(-1);
     }
 
-    return key_new(value[0], value[1]);
+    return oKey;
 }
 
 
@@ -86,5 +94,7 @@ void key_print(princev2key_t key) {
 
 /* creates string str for key */
 void princev2key_toString(princev2key_t key, char str[KEY_HEX_LENGTH + 1]) {
-    sprintf(str, "%016lx%016lx", key.k0, key.k1);
+    hex_encode64(key.k0, str);
+    hex_encode64(key.k1, str + HEX_DIGITS);
+    str[KEY_HEX_LENGTH] = '\0';
 }
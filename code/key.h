@@ -35,7 +35,10 @@ princev2key_t key_new(uint64_t k0, uint64_t k1);
 /* creates new princev2key_t from random values */
 princev2key_t key_newRandom();
 
-/* creates new princev2key_t from 48 character string */
+/* parses a 32 character hex string into key. Returns 0 if no error */
+int key_fromString(const char* keyString, princev2key_t* key);
+
+/* creates new princev2key_t from 32 character string, exits on an invalid string */
 princev2key_t key_newFromString(char keyString[KEY_HEX_LENGTH + 1]);
 
 /* sets key to random values */
@@ -2,8 +2,26 @@
 #define _MISC_
 
 #include <inttypes.h>
+#include <string.h>
 
 uint64_t llrand();
-int getInt(char c);
+
+/* reads a 64-bit block stored most significant byte first */
+static inline uint64_t loadBigEndian(const uint8_t* bytes) {
+    uint64_t block;
+    memcpy(&block, bytes, sizeof(block));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    block = __builtin_bswap64(block);
+#endif
+    return block;
+}
+
+/* stores a 64-bit block most significant byte first */
+static inline void storeBigEndian(uint8_t* bytes, uint64_t block) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    block = __builtin_bswap64(block);
+#endif
+    memcpy(bytes, &block, sizeof(block));
+}
 
 #endif
@@ -0,0 +1,90 @@
+/**
+princev1.c
+
+Implementation of the original PRINCE cipher as a key schedule for the
+PRINCEv2 round engine
+
+The round constants RC1..RC5 are the same in both ciphers, in PRINCE
+RC_i ^ RC_(11-i) = ALPHA for all i, so RC6..RC10 and RC11 follow from RCs.
+**/
+
+#include <assert.h>
+
+#include "princev1.h"
+#include "princev2engine.h"
+
+const uint64_t PRINCE_V1_RC11 = 0xc0ac29b7c97c50dd;
+
+/* round constant i of PRINCE, 0 <= i <= 11 */
+static uint64_t prince_v1_rc(int i) {
+    return i < NUM_OF_ROUNDS / 2 ? RCs[i] : RCs[NUM_OF_ROUNDS - 1 - i] ^ PRINCE_V1_RC11;
+}
+
+void prince_v1_roundKeys(princev2key_t key, princemode_t mode,
+                         uint64_t rk[NUM_OF_KEY_ADDITIONS]) {
+    uint64_t k0 = key.k0;
+    uint64_t k0prime = ((key.k0 >> 1) | (key.k0 << 63)) ^ (key.k0 >> 63);
+    uint64_t k1 = key.k1;
+    int k = 0;
+
+    /* D_(k0 || k0' || k1) = E_(k0' || k0 || k1 ^ ALPHA) */
+    if (mode == DEC) {
+        uint64_t tmp = k0;
+        k0 = k0prime;
+        k0prime = tmp;
+        k1 ^= PRINCE_V1_RC11;
+    }
+
+    rk[k++] = k0 ^ k1 ^ prince_v1_rc(0);
+    for (int i = 1; i < NUM_OF_ROUNDS / 2; i++) {
+        rk[k++] = k1 ^ prince_v1_rc(i);
+    }
+
+    /* the middle layer has no key addition */
+    rk[k++] = 0;
+    rk[k++] = 0;
+
+    for (int i = NUM_OF_ROUNDS / 2; i < NUM_OF_ROUNDS - 1; i++) {
+        rk[k++] = k1 ^ prince_v1_rc(i);
+    }
+
+    rk[k++] = k1 ^ prince_v1_rc(NUM_OF_ROUNDS - 1) ^ k0prime;
+}
+
+void prince_v1_ctx_init(princev2ctx_t* ctx, princev2key_t key) {
+    uint64_t enc[NUM_OF_KEY_ADDITIONS], dec[NUM_OF_KEY_ADDITIONS];
+
+    assert(ctx != NULL);
+
+    prince_v1_roundKeys(key, ENC, enc);
+    prince_v1_roundKeys(key, DEC, dec);
+    prince_ctx_fromRoundKeys(ctx, enc, dec);
+}
+
+uint64_t prince_v1_encrypt(princev2key_t key, uint64_t plaintext) {
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+
+    prince_v1_roundKeys(key, ENC, rk);
+    return prince_core_ctx(rk, plaintext);
+}
+
+uint64_t prince_v1_decrypt(princev2key_t key, uint64_t ciphertext) {
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+
+    prince_v1_roundKeys(key, DEC, rk);
+    return prince_core_ctx(rk, ciphertext);
+}
+
+void prince_v1_encrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    princev2ctx_t ctx;
+
+    prince_v1_ctx_init(&ctx, key);
+    prince_engine_encrypt_ctx(PRINCE_ENGINE_AUTO, &ctx, in, out, n);
+}
+
+void prince_v1_decrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    princev2ctx_t ctx;
+
+    prince_v1_ctx_init(&ctx, key);
+    prince_engine_decrypt_ctx(PRINCE_ENGINE_AUTO, &ctx, in, out, n);
+}
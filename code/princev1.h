@@ -0,0 +1,41 @@
+/**
+princev1.h
+
+Interface for the original PRINCE cipher on top of the PRINCEv2 round engine
+
+PRINCE and PRINCEv2 share the S-box, M' and SR layers and the round
+structure. PRINCE whitens with k0 and k0' = (k0 >>> 1) ^ (k0 >> 63), uses
+k1 in every round, has no key addition in the middle layer and decrypts
+with the alpha reflection property. Its key schedule is therefore just
+another list of key additions, and every engine runs it through a
+princev2ctx_t built by prince_v1_ctx_init.
+**/
+
+#ifndef _PRINCE_V1_
+#define _PRINCE_V1_
+
+#include <stddef.h>
+
+#include "key.h"
+#include "princev2.h"
+
+/* PRINCE round constant RC11, used in place of RC0 */
+extern const uint64_t PRINCE_V1_RC11;
+
+/* lists the key additions of the PRINCE core for key (k0, k1) in mode.
+   Unlike prince_roundKeys, key is the user key for both modes */
+void prince_v1_roundKeys(princev2key_t key, princemode_t mode,
+                         uint64_t rk[NUM_OF_KEY_ADDITIONS]);
+
+/* expands key for the _ctx functions and prince_engine_encrypt_ctx */
+void prince_v1_ctx_init(princev2ctx_t* ctx, princev2key_t key);
+
+uint64_t prince_v1_encrypt(princev2key_t key, uint64_t plaintext);
+uint64_t prince_v1_decrypt(princev2key_t key, uint64_t ciphertext);
+
+/* encrypts/decrypts n blocks from in to out on the engine picked by
+   princev2engine.h. in and out may be the same array */
+void prince_v1_encrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+void prince_v1_decrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+
+#endif
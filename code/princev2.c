@@ -7,8 +7,11 @@ Implementation for PRINCEv2 cipher
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "princev2.h"
+#include "princev2layers.h"
+#include "princev2profile.h"
 #include "block.h"
 
 /*
@@ -41,6 +44,14 @@ const char prince_shift_inverse[NUM_OF_NIBBLES] = {
     12,  9,  6,  3
 };
 
+/* nibble (column c, row r) of prince_m_mask[d] is m_{(2r + d + hat) mod 4},
+   with hat = 1 for the two MHat1 columns: row r of MHat0/MHat1 multiplies
+   the nibble d rows below it (cyclically) by that diagonal matrix. So M' is
+   the XOR over d of every column rotated up by d nibbles AND mask[d] */
+const uint64_t prince_m_mask[4] = {
+    PRINCE_M_MASK0, PRINCE_M_MASK1, PRINCE_M_MASK2, PRINCE_M_MASK3
+};
+
 const char prince_sbox[] = {
     0xb, 0xf, 0x3, 0x2,
     0xa, 0xc, 0x9, 0x1,
@@ -56,6 +67,7 @@ const char prince_sbox_inverse[] = {
 };
 
 uint64_t prince_s_layer(uint64_t iState, const char sbox[SBOX_SIZE]) {
+    PRINCE_PROFILE_BEGIN();
     uint64_t oState = 0;
 
     for (uint64_t i = 0; i < NUM_OF_NIBBLES; i++) {
@@ -63,10 +75,14 @@ uint64_t prince_s_layer(uint64_t iState, const char sbox[SBOX_SIZE]) {
         oState |= ((uint64_t) sbox[nibble]) << (4*i);
     }
 
+    PRINCE_PROFILE_END(PRINCE_PROFILE_S_LAYER);
     return oState;
 }
 
-/* multiplies matrix MHat0 by 4 elements of state beginning at starting index
+/* the original nibble by nibble M', kept as the specification of the word
+   level prince_m_layer below
+
+   multiplies matrix MHat0 by 4 elements of state beginning at starting index
    MHat0 =
    M0 M1 M2 M3
    M1 M2 M3 M0
@@ -130,7 +146,7 @@ static void prince_MHat1Multiply(uint64_t* state, int startingIndex ) {
    - - M^1 -
    - - - M^0
    */
-uint64_t prince_m_layer(uint64_t state) {
+uint64_t prince_m_layer_nibbles(uint64_t state) {
     prince_MHat0Multiply(&state, 0);
     prince_MHat1Multiply(&state, 4);
     prince_MHat1Multiply(&state, 8);
@@ -139,7 +155,18 @@ uint64_t prince_m_layer(uint64_t state) {
     return state;
 }
 
-uint64_t prince_permuteNibbles(uint64_t state, const char shift[NUM_OF_NIBBLES]) {
+uint64_t prince_m_layer(uint64_t state) {
+    PRINCE_PROFILE_BEGIN();
+    state = prince_word_m_layer(state);
+    PRINCE_PROFILE_END(PRINCE_PROFILE_M_LAYER);
+    return state;
+}
+
+uint64_t prince_shiftRowInverse_m_layer(uint64_t state) {
+    return prince_word_m_layer(prince_word_shiftRowInverse(state));
+}
+
+uint64_t prince_permuteNibbles(uint64_t state, const char shift[]) {
     block_t originalState = {state >> 32, state & 0xffffffff};
     block_t state_block = {state >> 32, state & 0xffffffff};
 
@@ -152,11 +179,17 @@ uint64_t prince_permuteNibbles(uint64_t state, const char shift[NUM_OF_NIBBLES])
 }
 
 uint64_t prince_shiftRow(uint64_t state) {
-    return prince_permuteNibbles(state, prince_shift);
+    PRINCE_PROFILE_BEGIN();
+    state = prince_word_shiftRow(state);
+    PRINCE_PROFILE_END(PRINCE_PROFILE_SHIFT_ROW);
+    return state;
 }
 
 uint64_t prince_shiftRowInverse(uint64_t state) {
-    return prince_permuteNibbles(state, prince_shift_inverse);
+    PRINCE_PROFILE_BEGIN();
+    state = prince_word_shiftRowInverse(state);
+    PRINCE_PROFILE_END(PRINCE_PROFILE_SHIFT_ROW_INVERSE);
+    return state;
 }
 
 
@@ -165,15 +198,13 @@ uint64_t prince_roundForward(uint64_t state, uint64_t rk, uint64_t RCi) {
     state = prince_m_layer(state);
     state = prince_shiftRow(state);
 
-    state ^= RCi;
-    state ^= rk;
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= RCi ^ rk);
 
     return state;
 }
 
 uint64_t prince_roundInverse(uint64_t state, uint64_t rk, uint64_t RCi) {
-    state ^= rk;
-    state ^= RCi;
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rk ^ RCi);
 
     state = prince_shiftRowInverse(state);
     state = prince_m_layer(state);
@@ -183,15 +214,16 @@ uint64_t prince_roundInverse(uint64_t state, uint64_t rk, uint64_t RCi) {
 }
 
 uint64_t prince_core(princev2key_t key, uint64_t state, princemode_t mode) {
+    PRINCE_PROFILE_CORE_BEGIN();
     uint64_t rkeys[] = {key.k0, key.k1};
-    state ^= rkeys[0];
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rkeys[0]);
 
     for (ssize_t i = 1; i < NUM_OF_ROUNDS / 2; i++) {
         state = prince_roundForward(state, rkeys[i % 2], RCs[i]);
     }
 
     state = prince_s_layer(state, prince_sbox);
-    state ^= rkeys[0];
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rkeys[0]);
     state = prince_m_layer(state);
 
     if (mode == DEC) {
@@ -199,15 +231,16 @@ uint64_t prince_core(princev2key_t key, uint64_t state, princemode_t mode) {
         rkeys[1] ^= ALPHA ^ BETA;
     }
 
-    state ^= rkeys[1] ^ BETA;
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rkeys[1] ^ BETA);
     state = prince_s_layer(state, prince_sbox_inverse);
 
     for (ssize_t i = NUM_OF_ROUNDS / 2; i < NUM_OF_ROUNDS - 1; i++) {
         state = prince_roundInverse(state, rkeys[i % 2], RCs[i]);
     }
 
-    state ^= rkeys[1] ^ BETA;
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rkeys[1] ^ BETA);
 
+    PRINCE_PROFILE_CORE_END();
     return state;
 }
 
@@ -218,3 +251,124 @@ uint64_t prince_encrypt(princev2key_t key, uint64_t plaintext) {
 uint64_t prince_decrypt(princev2key_t key, uint64_t ciphertext) {
     return prince_core(key_new(key.k1^BETA, key.k0^ALPHA), ciphertext, DEC);
 }
+
+void prince_roundKeys(princev2key_t key, princemode_t mode, uint64_t rk[NUM_OF_KEY_ADDITIONS]) {
+    uint64_t rkeys[] = {key.k0, key.k1};
+    int k = 0;
+
+    rk[k++] = rkeys[0];
+    for (ssize_t i = 1; i < NUM_OF_ROUNDS / 2; i++) {
+        rk[k++] = rkeys[i % 2] ^ RCs[i];
+    }
+
+    rk[k++] = rkeys[0];
+
+    if (mode == DEC) {
+        rkeys[0] ^= ALPHA ^ BETA;
+        rkeys[1] ^= ALPHA ^ BETA;
+    }
+
+    rk[k++] = rkeys[1] ^ BETA;
+    for (ssize_t i = NUM_OF_ROUNDS / 2; i < NUM_OF_ROUNDS - 1; i++) {
+        rk[k++] = rkeys[i % 2] ^ RCs[i];
+    }
+
+    rk[k++] = rkeys[1] ^ BETA;
+}
+
+void prince_roundKeyWords(princemode_t mode, uint64_t constant[NUM_OF_KEY_ADDITIONS],
+                          int word[NUM_OF_KEY_ADDITIONS]) {
+    uint64_t ones[NUM_OF_KEY_ADDITIONS];
+    princev2key_t zero = key_new(0, 0), k0 = key_new(~(uint64_t) 0, 0);
+
+    /* the decryption key swaps the words, see prince_decrypt */
+    if (mode == DEC) {
+        zero = key_new(zero.k1^BETA, zero.k0^ALPHA);
+        k0 = key_new(k0.k1^BETA, k0.k0^ALPHA);
+    }
+
+    prince_roundKeys(zero, mode, constant);
+    prince_roundKeys(k0, mode, ones);
+
+    for (int k = 0; k < NUM_OF_KEY_ADDITIONS; k++) {
+        word[k] = ones[k] == constant[k];
+    }
+}
+
+void prince_ctx_fromRoundKeys(princev2ctx_t* ctx, const uint64_t enc[NUM_OF_KEY_ADDITIONS],
+                              const uint64_t dec[NUM_OF_KEY_ADDITIONS]) {
+    assert(ctx != NULL);
+
+    memcpy(ctx->enc, enc, sizeof(ctx->enc));
+    memcpy(ctx->dec, dec, sizeof(ctx->dec));
+
+    /* the inverse rounds start after the whitening, 5 forward rounds and
+       the two middle layer additions */
+    enc = ctx->enc + NUM_OF_ROUNDS / 2 + 2;
+    dec = ctx->dec + NUM_OF_ROUNDS / 2 + 2;
+
+    for (ssize_t i = 0; i < NUM_OF_INVERSE_ROUNDS; i++) {
+        ctx->encLinear[i] = prince_shiftRowInverse_m_layer(enc[i]);
+        ctx->decLinear[i] = prince_shiftRowInverse_m_layer(dec[i]);
+    }
+}
+
+void prince_ctx_init(princev2ctx_t* ctx, princev2key_t key) {
+    uint64_t enc[NUM_OF_KEY_ADDITIONS], dec[NUM_OF_KEY_ADDITIONS];
+
+    prince_roundKeys(key, ENC, enc);
+    prince_roundKeys(key_new(key.k1^BETA, key.k0^ALPHA), DEC, dec);
+    prince_ctx_fromRoundKeys(ctx, enc, dec);
+}
+
+/* same as prince_core, with all key arithmetic done by prince_roundKeys */
+uint64_t prince_core_ctx(const uint64_t rk[NUM_OF_KEY_ADDITIONS], uint64_t state) {
+    return prince_core_rounds(rk, state, NUM_OF_FORWARD_ROUNDS, 1, NUM_OF_INVERSE_ROUNDS);
+}
+
+uint64_t prince_core_rounds(const uint64_t rk[NUM_OF_KEY_ADDITIONS], uint64_t state,
+                            int forward, int middle, int backward) {
+    assert(forward >= 0 && forward <= NUM_OF_FORWARD_ROUNDS);
+    assert(backward >= 0 && backward <= NUM_OF_INVERSE_ROUNDS);
+    PRINCE_PROFILE_CORE_BEGIN();
+
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rk[0]);
+
+    for (ssize_t i = 1; i <= forward; i++) {
+        state = prince_s_layer(state, prince_sbox);
+        state = prince_m_layer(state);
+        state = prince_shiftRow(state);
+        PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rk[i]);
+    }
+
+    if (middle) {
+        state = prince_s_layer(state, prince_sbox);
+        PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rk[NUM_OF_ROUNDS / 2]);
+        state = prince_m_layer(state);
+        PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION,
+                                 state ^= rk[NUM_OF_ROUNDS / 2 + 1]);
+        state = prince_s_layer(state, prince_sbox_inverse);
+    }
+
+    /* inverse round i adds key i + 2 */
+    for (ssize_t i = NUM_OF_ROUNDS - 1 - backward; i < NUM_OF_ROUNDS - 1; i++) {
+        PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, state ^= rk[i + 2]);
+        state = prince_shiftRowInverse(state);
+        state = prince_m_layer(state);
+        state = prince_s_layer(state, prince_sbox_inverse);
+    }
+
+    PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION,
+                             state ^= rk[NUM_OF_KEY_ADDITIONS - 1]);
+
+    PRINCE_PROFILE_CORE_END();
+    return state;
+}
+
+uint64_t prince_encrypt_ctx(const princev2ctx_t* ctx, uint64_t plaintext) {
+    return prince_core_ctx(ctx->enc, plaintext);
+}
+
+uint64_t prince_decrypt_ctx(const princev2ctx_t* ctx, uint64_t ciphertext) {
+    return prince_core_ctx(ctx->dec, ciphertext);
+}
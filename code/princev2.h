@@ -1,6 +1,8 @@
 #ifndef _PRINCE_
 #define _PRINCE_
 
+#include <stddef.h>
+
 #include "key.h"
 
 /* SBOX_SIZE must be equivalent to 2 ** NIBBLE_SIZE */
@@ -8,17 +10,105 @@ enum {SBOX_SIZE = 16};
 enum {NUM_OF_ROUNDS = 12};
 typedef enum {ENC, DEC} princemode_t;
 
+/* key additions in prince_core: whitening, 5 forward rounds, 2 in the
+   middle layer, 5 inverse rounds and the final whitening */
+enum {NUM_OF_KEY_ADDITIONS = NUM_OF_ROUNDS + 2};
+enum {NUM_OF_INVERSE_ROUNDS = NUM_OF_ROUNDS / 2 - 1};
+enum {NUM_OF_FORWARD_ROUNDS = NUM_OF_ROUNDS / 2 - 1};
+
+/* expanded key for both directions. enc and dec hold every key addition
+   of prince_core in order for encryption and decryption, with the round
+   constants, BETA and the ALPHA ^ BETA adjustment for decryption already
+   applied. encLinear and decLinear hold the keys of the inverse rounds of
+   enc and dec pushed through M' o SR^-1, which is what the table engine
+   adds */
+typedef struct princev2ctx {
+    uint64_t enc[NUM_OF_KEY_ADDITIONS];
+    uint64_t dec[NUM_OF_KEY_ADDITIONS];
+    uint64_t encLinear[NUM_OF_INVERSE_ROUNDS];
+    uint64_t decLinear[NUM_OF_INVERSE_ROUNDS];
+} princev2ctx_t;
+
 extern const char prince_sbox[];
 extern const char prince_sbox_inverse[];
+extern const char prince_shift[];
+extern const char prince_shift_inverse[];
+/* diagonal masks of M', see princev2.c */
+extern const uint64_t prince_m_mask[4];
 
 uint64_t prince_s_layer(uint64_t state, const char sbox[SBOX_SIZE]);
 uint64_t prince_m_layer(uint64_t state);
 uint64_t prince_shiftRow(uint64_t state);
+uint64_t prince_shiftRowInverse(uint64_t state);
+
+/* the linear layer of the inverse rounds in one step:
+   prince_m_layer(prince_shiftRowInverse(x)) */
+uint64_t prince_shiftRowInverse_m_layer(uint64_t state);
+
+/* prince_m_layer, and nibble i of the result being nibble shift[i] of
+   state, nibble by nibble with block_getNibble/block_setNibble as in the
+   specification. Slow, for checking the word level versions:
+   prince_permuteNibbles(x, prince_shift) is prince_shiftRow(x) */
+uint64_t prince_m_layer_nibbles(uint64_t state);
+uint64_t prince_permuteNibbles(uint64_t state, const char shift[]);
 uint64_t prince_roundForward(uint64_t k1, uint64_t state, uint64_t RCi);
 uint64_t prince_roundInverse(uint64_t k1, uint64_t state, uint64_t RCi);
 uint64_t prince_core(princev2key_t key, uint64_t state, princemode_t dec);
 uint64_t prince_encrypt(princev2key_t key, uint64_t plaintext);
 uint64_t prince_decrypt(princev2key_t key, uint64_t ciphertext);
 
+/* encrypts/decrypts n blocks from in to out on the engine picked by
+   princev2engine.h. in and out may be the same buffer (but must not overlap
+   otherwise) and need not be aligned */
+void prince_encrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+void prince_decrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+
+/* same with a key of its own for every block: in[i] goes through keys[i].
+   The SIMD and bitsliced engines run one key per lane */
+void prince_encrypt_keys_blocks(const princev2key_t* keys, const uint64_t* in,
+                                uint64_t* out, size_t n);
+void prince_decrypt_keys_blocks(const princev2key_t* keys, const uint64_t* in,
+                                uint64_t* out, size_t n);
+
+/* lists the key additions of prince_core for key in mode. For DEC, key has
+   to be the decryption key as built by prince_decrypt */
+void prince_roundKeys(princev2key_t key, princemode_t mode, uint64_t rk[NUM_OF_KEY_ADDITIONS]);
+
+/* the key additions are linear in the user key: for encryption (ENC) or
+   decryption (DEC) under key, rk[k] is k0 if word[k] is 0 and k1 if it is
+   1, XOR constant[k]. For engines that expand a different key per lane */
+void prince_roundKeyWords(princemode_t mode, uint64_t constant[NUM_OF_KEY_ADDITIONS],
+                          int word[NUM_OF_KEY_ADDITIONS]);
+
+/* expands key once, for any number of prince_encrypt_ctx/prince_decrypt_ctx */
+void prince_ctx_init(princev2ctx_t* ctx, princev2key_t key);
+
+/* builds ctx from the key addition lists of both directions, for ciphers
+   that share the round engine but not the key schedule */
+void prince_ctx_fromRoundKeys(princev2ctx_t* ctx, const uint64_t enc[NUM_OF_KEY_ADDITIONS],
+                              const uint64_t dec[NUM_OF_KEY_ADDITIONS]);
+uint64_t prince_core_ctx(const uint64_t rk[NUM_OF_KEY_ADDITIONS], uint64_t state);
+uint64_t prince_encrypt_ctx(const princev2ctx_t* ctx, uint64_t plaintext);
+uint64_t prince_decrypt_ctx(const princev2ctx_t* ctx, uint64_t ciphertext);
+
+/* reduced-round PRINCEv2 for cryptanalysis: the whitening, forward rounds
+   1..forward, the middle layer if middle is nonzero, inverse rounds
+   11 - backward..10 and the final whitening, each with its key addition
+   from rk. 0 <= forward <= NUM_OF_FORWARD_ROUNDS and
+   0 <= backward <= NUM_OF_INVERSE_ROUNDS, (5, 1, 5) is prince_core_ctx */
+uint64_t prince_core_rounds(const uint64_t rk[NUM_OF_KEY_ADDITIONS], uint64_t state,
+                            int forward, int middle, int backward);
+
+/* prince_core_rounds on n blocks from in to out on the engine picked by
+   princev2engine.h, every engine but the reference one has an unrolled core
+   for each number of rounds. prince_decrypt_rounds_blocks inverts it under
+   the same rk. Returns 0 if no error */
+int prince_encrypt_rounds_blocks(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n);
+int prince_decrypt_rounds_blocks(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n);
+
 #endif
 
@@ -0,0 +1,644 @@
+/**
+princev2analysis.c
+
+This program estimates differential probabilities and linear correlations
+of (reduced-round) PRINCEv2 over many random plaintexts and keys, and
+prints the difference distribution table (DDT) and linear approximation
+table (LAT) of the S-box and the branch numbers of the M' layer. Integral
+mode encrypts structured sets, all values in the active nibbles and fixed
+random values in the others, and checks which output nibbles sum to zero.
+
+Sample Usage:
+
+S-box tables and M' branch numbers:
+> princev2analysis ddt
+> princev2analysis lat
+> princev2analysis mlayer
+
+Probability of output difference 0000000000000001 for input difference
+0000000000000010 over 2 forward rounds, 2^30 pairs:
+> princev2analysis diff 10 1 30 --rounds 2/0/0
+
+Correlation of input mask a and output mask b over 2^30 plaintexts:
+> princev2analysis linear a b 30 --rounds 1/1/1
+
+Balanced nibbles after 3 and 4 forward rounds of 2^10 sets with the last
+column active (2^16 plaintexts each):
+> princev2analysis integral CCCCCCCCCCCCAAAA 10 --rounds 3/0/0,4/0/0
+
+--rounds forward/middle/backward selects the reduced cipher of
+prince_core_rounds (default 5/1/5, the full cipher), integral mode takes a
+comma separated list. Every worker thread draws a new random key for every
+KEY_BLOCKS blocks, or every integral set, from its own substream of
+--seed, so results are reproducible for a given seed and thread count.
+The blocks go through the unrolled reduced-round core of the engine
+picked by princev2engine.h, --engine (or PRINCEV2_ENGINE) forces one,
+e.g. --engine bitslice for the 64-way bitsliced engine.
+The sign of a linear correlation usually depends on the key, so linear
+mode also reports the mean over keys of the squared correlation.
+Integral sets are generated and summed ANALYSIS_BLOCKS at a time, so even
+sets of 2^32 plaintexts never leave the first level cache.
+
+Sample build:
+> make princev2analysis
+**/
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "block.h"
+#include "hex.h"
+#include "key.h"
+#include "princev2.h"
+#include "princev2engine.h"
+#include "prng.h"
+
+/* blocks per engine call, and blocks encrypted under one random key */
+enum{ANALYSIS_BLOCKS = 4096};
+enum{KEY_BLOCKS = 1 << 16};
+
+enum{MAX_THREADS = 256};
+enum{MAX_LOG_SAMPLES = 50};
+enum{MAX_ROUND_LISTS = 16};
+
+/* 2^32 plaintexts per integral set */
+enum{MAX_ACTIVE_NIBBLES = 8};
+
+/* bits and nibbles of one 16-bit column of M' */
+enum{COLUMN_BITS = 16};
+enum{NUM_OF_COLUMNS = 4};
+
+typedef enum {ANALYSIS_DIFFERENTIAL, ANALYSIS_LINEAR} analysis_t;
+
+typedef struct rounds {
+    int forward, middle, backward;
+} rounds_t;
+
+/* command line options shared by all experiments */
+typedef struct options {
+    rounds_t rounds[MAX_ROUND_LISTS];
+    int numRounds;
+    uint64_t seed;
+    int threads;
+} options_t;
+
+typedef struct experiment {
+    analysis_t type;
+    uint64_t in;    /* input difference or mask */
+    uint64_t out;   /* output difference or mask */
+    uint64_t samples;
+    options_t options;
+} experiment_t;
+
+typedef struct worker {
+    const experiment_t* experiment;
+    int index;
+    uint64_t samples;
+    uint64_t hits;
+    double squares; /* sum over keys of the squared correlation */
+    uint64_t keys;
+} worker_t;
+
+/* an integral set takes all values in the active nibbles and fixed random
+   values elsewhere, spread[b][v] places byte b of the set index */
+typedef struct integral {
+    uint64_t active;
+    int numActive;
+    uint64_t sets;
+    uint64_t spread[MAX_ACTIVE_NIBBLES / 2][256];
+    options_t options;
+} integral_t;
+
+typedef struct integralworker {
+    const integral_t* integral;
+    int index;
+    uint64_t sets;
+    /* number of sets whose ciphertexts sum to zero in each nibble */
+    uint64_t zero[MAX_ROUND_LISTS][NUM_OF_NIBBLES];
+} integralworker_t;
+
+static int parity(uint64_t x) {
+    return __builtin_parityll(x);
+}
+
+/* number of nonzero nibbles */
+static int nibbleWeight(uint64_t x) {
+    x = (x | (x >> 1) | (x >> 2) | (x >> 3)) & 0x1111111111111111;
+    return __builtin_popcountll(x);
+}
+
+static void printDDT() {
+    printf("DDT of prince_sbox, row = input difference, column = output difference\n");
+    for (int a = 0; a < SBOX_SIZE; a++) {
+        int row[SBOX_SIZE] = {0};
+
+        for (int x = 0; x < SBOX_SIZE; x++) {
+            row[prince_sbox[x] ^ prince_sbox[x ^ a]]++;
+        }
+
+        printf("%x:", a);
+        for (int b = 0; b < SBOX_SIZE; b++) {
+            printf(" %2d", row[b]);
+        }
+        printf("\n");
+    }
+}
+
+static void printLAT() {
+    printf("LAT of prince_sbox, #{x : a.x = b.S(x)} - 8, row = a, column = b\n");
+    for (int a = 0; a < SBOX_SIZE; a++) {
+        printf("%x:", a);
+        for (int b = 0; b < SBOX_SIZE; b++) {
+            int count = 0;
+
+            for (int x = 0; x < SBOX_SIZE; x++) {
+                count += parity(a & x) == parity(b & prince_sbox[x]);
+            }
+            printf(" %2d", count - SBOX_SIZE / 2);
+        }
+        printf("\n");
+    }
+}
+
+/* M' as 64 columns of a binary matrix, column i is the image of bit i */
+static void mLayerMatrix(uint64_t matrix[64], int transpose) {
+    uint64_t m[64];
+
+    for (int i = 0; i < 64; i++) {
+        m[i] = prince_m_layer((uint64_t) 1 << i);
+    }
+
+    for (int i = 0; i < 64; i++) {
+        matrix[i] = 0;
+        for (int j = 0; j < 64; j++) {
+            uint64_t bit = transpose ? (m[j] >> i) & 1 : (m[i] >> j) & 1;
+            matrix[i] |= bit << j;
+        }
+    }
+}
+
+static uint64_t mLayerApply(const uint64_t matrix[64], uint64_t x) {
+    uint64_t y = 0;
+
+    for (int i = 0; i < 64; i++) {
+        if ((x >> i) & 1) {
+            y ^= matrix[i];
+        }
+    }
+
+    return y;
+}
+
+/* branch numbers of every 16-bit column of M', differential (M') and
+   linear (transpose of M'), with the number of inputs reaching them */
+static void printMLayer() {
+    printf("M' branch numbers per column, min over nonzero x of nibbles(x) + nibbles(M'(x))\n");
+    printf("column  differential  count  linear  count\n");
+
+    for (int column = 0; column < NUM_OF_COLUMNS; column++) {
+        int shift = COLUMN_BITS * (NUM_OF_COLUMNS - 1 - column);
+        int best[2] = {2 * NUM_OF_COLUMNS + 1, 2 * NUM_OF_COLUMNS + 1};
+        int count[2] = {0, 0};
+
+        for (int transpose = 0; transpose < 2; transpose++) {
+            uint64_t matrix[64];
+            mLayerMatrix(matrix, transpose);
+
+            for (uint64_t v = 1; v < (1 << COLUMN_BITS); v++) {
+                uint64_t x = v << shift;
+                int branch = nibbleWeight(x) + nibbleWeight(mLayerApply(matrix, x));
+
+                if (branch < best[transpose]) {
+                    best[transpose] = branch;
+                    count[transpose] = 0;
+                }
+                count[transpose] += branch == best[transpose];
+            }
+        }
+
+        printf("%6d  %12d  %5d  %6d  %5d\n", column, best[0], count[0], best[1], count[1]);
+    }
+}
+
+/* adds the counts of the key that was just used to worker */
+static void finishKey(worker_t* worker, uint64_t hits, uint64_t samples) {
+    if (samples > 0) {
+        double correlation = 2.0 * hits / samples - 1;
+        worker->hits += hits;
+        worker->squares += correlation * correlation;
+        worker->keys++;
+    }
+}
+
+static void* runWorker(void* arg) {
+    worker_t* worker = arg;
+    const experiment_t* e = worker->experiment;
+    const rounds_t* r = &e->options.rounds[0];
+    uint64_t p[ANALYSIS_BLOCKS], q[ANALYSIS_BLOCKS], c[ANALYSIS_BLOCKS], d[ANALYSIS_BLOCKS];
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+    uint64_t done = 0, hits = 0, keyDone = 0;
+    prng_t rng;
+
+    prng_seed(&rng, e->options.seed);
+    for (int j = 0; j < worker->index; j++) {
+        prng_jump(&rng);
+    }
+
+    while (done < worker->samples) {
+        size_t n = worker->samples - done < ANALYSIS_BLOCKS ? worker->samples - done
+                                                             : ANALYSIS_BLOCKS;
+
+        if (done % KEY_BLOCKS == 0) {
+            princev2key_t key;
+
+            finishKey(worker, hits, keyDone);
+            hits = keyDone = 0;
+            key.k0 = prng_next(&rng);
+            key.k1 = prng_next(&rng);
+            prince_roundKeys(key, ENC, rk);
+        }
+
+        prng_fill(&rng, p, n);
+        prince_encrypt_rounds_blocks(rk, r->forward, r->middle, r->backward, p, c, n);
+
+        if (e->type == ANALYSIS_DIFFERENTIAL) {
+            for (size_t i = 0; i < n; i++) {
+                q[i] = p[i] ^ e->in;
+            }
+            prince_encrypt_rounds_blocks(rk, r->forward, r->middle, r->backward, q, d, n);
+
+            for (size_t i = 0; i < n; i++) {
+                hits += (c[i] ^ d[i]) == e->out;
+            }
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                hits += parity((p[i] & e->in) ^ (c[i] & e->out)) == 0;
+            }
+        }
+
+        done += n;
+        keyDone += n;
+    }
+
+    finishKey(worker, hits, keyDone);
+    return NULL;
+}
+
+/* runs fn on workers[0..threads) of size bytes each, worker 0 on the calling thread */
+static void runThreads(void* (*fn)(void*), void* workers, size_t size, int threads) {
+    pthread_t tids[MAX_THREADS];
+
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, fn, (char*) workers + t * size) != 0) {
+            fprintf(stderr, "runThreads: cannot start thread %d\n", t);
+            exit(-1);
+        }
+    }
+    fn(workers);
+
+    for (int t = 1; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+}
+
+static void runExperiment(const experiment_t* e) {
+    const rounds_t* r = &e->options.rounds[0];
+    int threads = e->options.threads;
+    worker_t workers[MAX_THREADS];
+
+    for (int t = 0; t < threads; t++) {
+        workers[t].experiment = e;
+        workers[t].index = t;
+        workers[t].samples = e->samples / threads + ((uint64_t) t < e->samples % threads);
+        workers[t].hits = 0;
+        workers[t].squares = 0;
+        workers[t].keys = 0;
+    }
+
+    runThreads(runWorker, workers, sizeof(worker_t), threads);
+
+    uint64_t hits = 0, keys = 0;
+    double squares = 0;
+    for (int t = 0; t < threads; t++) {
+        hits += workers[t].hits;
+        keys += workers[t].keys;
+        squares += workers[t].squares;
+    }
+
+    double samples = (double) e->samples;
+    printf("rounds %d/%d/%d on %s, %s %016lx -> %016lx\n", r->forward, r->middle, r->backward,
+           prince_engine_name(prince_engine_get()),
+           e->type == ANALYSIS_DIFFERENTIAL ? "difference" : "mask", e->in, e->out);
+
+    if (e->type == ANALYSIS_DIFFERENTIAL) {
+        double probability = hits / samples;
+        printf("pairs 2^%.2f, hits %lu, probability %.6g (2^%.2f)\n", log2(samples), hits,
+               probability, hits ? log2(probability) : -INFINITY);
+    } else {
+        double correlation = 2 * hits / samples - 1;
+        double potential = squares / keys;
+        printf("plaintexts 2^%.2f, agreements %lu, correlation %.6g (2^%.2f)\n",
+               log2(samples), hits, correlation,
+               correlation != 0 ? log2(fabs(correlation)) : -INFINITY);
+        printf("keys %lu, mean squared correlation per key %.6g (2^%.2f)\n", keys, potential,
+               potential != 0 ? log2(potential) : -INFINITY);
+    }
+}
+
+/* XOR of n blocks, four independent chains */
+static uint64_t xorBlocks(const uint64_t* in, size_t n) {
+    uint64_t x0 = 0, x1 = 0, x2 = 0, x3 = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        x0 ^= in[i];
+        x1 ^= in[i + 1];
+        x2 ^= in[i + 2];
+        x3 ^= in[i + 3];
+    }
+    for (; i < n; i++) {
+        x0 ^= in[i];
+    }
+
+    return x0 ^ x1 ^ x2 ^ x3;
+}
+
+static void* runIntegralWorker(void* arg) {
+    integralworker_t* worker = arg;
+    const integral_t* g = worker->integral;
+    const options_t* o = &g->options;
+    uint64_t p[ANALYSIS_BLOCKS], c[ANALYSIS_BLOCKS];
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+    uint64_t size = (uint64_t) 1 << (4 * g->numActive);
+    prng_t rng;
+
+    prng_seed(&rng, o->seed);
+    for (int j = 0; j < worker->index; j++) {
+        prng_jump(&rng);
+    }
+
+    for (uint64_t set = 0; set < worker->sets; set++) {
+        uint64_t sums[MAX_ROUND_LISTS] = {0};
+        princev2key_t key;
+
+        key.k0 = prng_next(&rng);
+        key.k1 = prng_next(&rng);
+        prince_roundKeys(key, ENC, rk);
+        uint64_t base = prng_next(&rng) & ~g->active;
+
+        for (uint64_t v = 0; v < size; v += ANALYSIS_BLOCKS) {
+            size_t n = size - v < ANALYSIS_BLOCKS ? size - v : ANALYSIS_BLOCKS;
+
+            for (size_t i = 0; i < n; i++) {
+                uint64_t index = v + i;
+                p[i] = base | g->spread[0][index & 0xff] | g->spread[1][(index >> 8) & 0xff] |
+                       g->spread[2][(index >> 16) & 0xff] | g->spread[3][index >> 24];
+            }
+
+            for (int r = 0; r < o->numRounds; r++) {
+                const rounds_t* rounds = &o->rounds[r];
+                prince_encrypt_rounds_blocks(rk, rounds->forward, rounds->middle,
+                                             rounds->backward, p, c, n);
+                sums[r] ^= xorBlocks(c, n);
+            }
+        }
+
+        for (int r = 0; r < o->numRounds; r++) {
+            for (int nibble = 0; nibble < NUM_OF_NIBBLES; nibble++) {
+                worker->zero[r][nibble] += ((sums[r] >> (60 - 4 * nibble)) & 0xf) == 0;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void runIntegral(integral_t* g, const char* pattern) {
+    static integralworker_t workers[MAX_THREADS];
+    int threads = g->options.threads;
+
+    /* the k-th active nibble from the right takes bits 4k..4k+3 of the index */
+    memset(g->spread, 0, sizeof(g->spread));
+    for (int v = 0; v < 256; v++) {
+        int k = 0;
+        for (int nibble = NUM_OF_NIBBLES - 1; nibble >= 0; nibble--) {
+            int shift = 60 - 4 * nibble;
+            if (!((g->active >> shift) & 1)) {
+                continue;
+            }
+            g->spread[k / 2][v] |= (uint64_t) ((v >> (4 * (k % 2))) & 0xf) << shift;
+            k++;
+        }
+    }
+
+    if ((uint64_t) threads > g->sets) {
+        threads = g->sets;
+    }
+
+    for (int t = 0; t < threads; t++) {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].integral = g;
+        workers[t].index = t;
+        workers[t].sets = g->sets / threads + ((uint64_t) t < g->sets % threads);
+    }
+
+    runThreads(runIntegralWorker, workers, sizeof(integralworker_t), threads);
+
+    printf("pattern %s, sets %lu of 2^%d plaintexts on %s\n", pattern, g->sets,
+           4 * g->numActive, prince_engine_name(prince_engine_get()));
+    printf("rounds   balanced          zero sums per nibble\n");
+
+    for (int r = 0; r < g->options.numRounds; r++) {
+        const rounds_t* rounds = &g->options.rounds[r];
+        char balanced[NUM_OF_NIBBLES + 1] = {0};
+        uint64_t zero[NUM_OF_NIBBLES] = {0};
+
+        for (int nibble = 0; nibble < NUM_OF_NIBBLES; nibble++) {
+            for (int t = 0; t < threads; t++) {
+                zero[nibble] += workers[t].zero[r][nibble];
+            }
+            balanced[nibble] = zero[nibble] == g->sets ? 'B' : '.';
+        }
+
+        printf("%d/%d/%d    %s ", rounds->forward, rounds->middle, rounds->backward, balanced);
+        for (int nibble = 0; nibble < NUM_OF_NIBBLES; nibble++) {
+            printf(" %lu", zero[nibble]);
+        }
+        printf("\n");
+    }
+}
+
+/* parses forward/middle/backward[,forward/middle/backward...] into options,
+   returns 0 if no error */
+static int parseRounds(const char* str, options_t* options) {
+    options->numRounds = 0;
+
+    while (options->numRounds < MAX_ROUND_LISTS) {
+        rounds_t* r = &options->rounds[options->numRounds];
+        int length = 0;
+
+        if (sscanf(str, "%d/%d/%d%n", &r->forward, &r->middle, &r->backward, &length) != 3 ||
+            r->forward < 0 || r->forward > NUM_OF_FORWARD_ROUNDS ||
+            r->backward < 0 || r->backward > NUM_OF_INVERSE_ROUNDS) {
+            return -1;
+        }
+        r->middle = r->middle != 0;
+        options->numRounds++;
+
+        str += length;
+        if (*str == '\0') {
+            return 0;
+        } else if (*str != ',') {
+            return -1;
+        }
+        str++;
+    }
+
+    return -1;
+}
+
+/* parses the options in argv[first..argc), returns 0 if no error */
+static int parseOptions(int argc, char* argv[], int first, options_t* options) {
+    options->rounds[0] = (rounds_t) {NUM_OF_FORWARD_ROUNDS, 1, NUM_OF_INVERSE_ROUNDS};
+    options->numRounds = 1;
+    options->seed = 0;
+    options->threads = 0;
+
+    for (int i = first; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            if (parseRounds(argv[++i], options) != 0) {
+                fprintf(stderr, "invalid rounds %s\n", argv[i]);
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options->threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            options->seed = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--engine") && i + 1 < argc) {
+            princeengine_t engine;
+
+            if (prince_engine_fromName(argv[++i], &engine) != 0) {
+                fprintf(stderr, "unknown engine %s\n", argv[i]);
+                return -1;
+            }
+            if (prince_engine_set(engine) != 0) {
+                return -1;
+            }
+        } else {
+            return -1;
+        }
+    }
+
+    if (options->threads <= 0) {
+        options->threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (options->threads > MAX_THREADS) {
+        options->threads = MAX_THREADS;
+    }
+    if (options->threads < 1) {
+        options->threads = 1;
+    }
+
+    return 0;
+}
+
+/* parses the sample count 2^argument, returns 0 if no error */
+static int parseLogCount(const char* str, uint64_t* count) {
+    char* end;
+    long log = strtol(str, &end, 10);
+
+    if (*str == '\0' || *end != '\0' || log < 0 || log > MAX_LOG_SAMPLES) {
+        fprintf(stderr, "log2 of the count must be 0 to %d\n", MAX_LOG_SAMPLES);
+        return -1;
+    }
+
+    *count = (uint64_t) 1 << log;
+    return 0;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s ddt | lat | mlayer\n"
+            "       %s diff <in> <out> <log2 pairs> [options]\n"
+            "       %s linear <in mask> <out mask> <log2 plaintexts> [options]\n"
+            "       %s integral <pattern> <log2 sets> [options]\n"
+            "options: --rounds forward/middle/backward[,...]  --threads T  --seed S\n"
+            "         --engine reference | table | bitslice | ssse3 | avx2 | avx512\n",
+            name, name, name, name);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && !strcmp(argv[1], "ddt")) {
+        printDDT();
+        return 0;
+    } else if (argc == 2 && !strcmp(argv[1], "lat")) {
+        printLAT();
+        return 0;
+    } else if (argc == 2 && !strcmp(argv[1], "mlayer")) {
+        printMLayer();
+        return 0;
+    }
+
+    if (argc >= 4 && !strcmp(argv[1], "integral")) {
+        static integral_t g;
+        const char* pattern = argv[2];
+
+        if (strlen(pattern) != NUM_OF_NIBBLES) {
+            fprintf(stderr, "the pattern needs one A or C per nibble\n");
+            return -1;
+        }
+        for (int nibble = 0; nibble < NUM_OF_NIBBLES; nibble++) {
+            if (pattern[nibble] == 'A' || pattern[nibble] == 'a') {
+                g.active |= (uint64_t) 0xf << (60 - 4 * nibble);
+                g.numActive++;
+            } else if (pattern[nibble] != 'C' && pattern[nibble] != 'c') {
+                fprintf(stderr, "the pattern needs one A or C per nibble\n");
+                return -1;
+            }
+        }
+        if (g.numActive > MAX_ACTIVE_NIBBLES) {
+            fprintf(stderr, "at most %d active nibbles\n", MAX_ACTIVE_NIBBLES);
+            return -1;
+        }
+
+        if (parseLogCount(argv[3], &g.sets) != 0) {
+            return -1;
+        }
+        if (parseOptions(argc, argv, 4, &g.options) != 0) {
+            usage(argv[0]);
+            return -1;
+        }
+
+        runIntegral(&g, pattern);
+        return 0;
+    }
+
+    if (argc < 5 || (strcmp(argv[1], "diff") && strcmp(argv[1], "linear"))) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    experiment_t e;
+    e.type = strcmp(argv[1], "diff") ? ANALYSIS_LINEAR : ANALYSIS_DIFFERENTIAL;
+
+    if (hex_parse(argv[2], strlen(argv[2]), &e.in) != 0 ||
+        hex_parse(argv[3], strlen(argv[3]), &e.out) != 0) {
+        fprintf(stderr, "failed to parse %s %s\n", argv[2], argv[3]);
+        return -1;
+    }
+
+    if (parseLogCount(argv[4], &e.samples) != 0) {
+        return -1;
+    }
+    if (parseOptions(argc, argv, 5, &e.options) != 0 || e.options.numRounds != 1) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    runExperiment(&e);
+    return 0;
+}
@@ -0,0 +1,623 @@
+/**
+princev2bench.c
+
+This program measures the cycles per block and per byte of every PRINCEv2
+engine this CPU supports, and of the layers of the reference
+implementation. Results are written to stdout as CSV (default) or JSON,
+one row per measurement.
+
+Every engine is measured for encryption and decryption, for message sizes
+from 1 block growing by a factor of 8 up to --max-bytes, and
+  - batched: one call for the whole message under one key
+  - single:  one call per block under one key
+  - per-block keys: one call per block, every block under another key
+  - batched per-block keys: one multi-key call, every block under another key
+The layers are measured as a dependent chain of calls, i.e. their latency.
+So is a whole block, where every ciphertext is the next plaintext: with
+prince_encrypt (reference), prince_encrypt_ctx (reference-ctx) and the
+inlined prince_encrypt_fast of princev2fast.h (fast), call "chained", and
+for the original PRINCE with prince_v1_encrypt (reference) and a
+prince_v1_ctx_init key (reference-ctx).
+Every row has ns_per_block next to the throughput columns, for chained
+rows that is the latency of one block.
+
+The MAC rows (operation "mac") compare PMAC of princev2pmac.h on the
+engine picked for PRINCE_ENGINE_AUTO (or --engine), on one thread (pmac)
+and on all of them (pmac-threads), with a serial CBC-MAC (cbc-mac) on
+prince_encrypt_fast (implementation "fast"), for a cache line, a 4K page
+and --max-bytes.
+
+To compare PRINCEv2 with the original PRINCE, both are also measured with
+a key expanded once (prince_ctx_init and prince_v1_ctx_init), batched and
+with one call per block, on every engine. The cipher column tells them
+apart.
+
+Cycles are read with rdtsc on x86 (TSC ticks, which run at the nominal
+clock) and derived from clock_gettime elsewhere. Every row is the fastest
+of several trials.
+
+Sample Usage:
+
+> princev2bench
+> princev2bench --json --engine avx2 --max-bytes 1G
+
+Sample build:
+> make princev2bench
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "key.h"
+#include "misc.h"
+#include "princev2.h"
+#include "princev2engine.h"
+#include "princev2fast.h"
+#include "princev2pmac.h"
+#include "princev1.h"
+#include "prng.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_RDTSC 1
+#else
+#define BENCH_HAVE_RDTSC 0
+#endif
+
+enum{BLOCK_BYTES = sizeof(uint64_t)};
+
+/* default largest message, --max-bytes goes up to GBs */
+enum{DEFAULT_MAX_BYTES = 1 << 20};
+
+/* a trial covers at least this many blocks, so small messages are not
+   dominated by reading the clock */
+enum{MIN_TRIAL_BLOCKS = 1024};
+
+/* trials per row, unless a single trial already takes MIN_CYCLES */
+enum{MIN_TRIALS = 3};
+#define MIN_CYCLES 20000000.0
+
+/* per-block keys cycle through this many keys */
+enum{KEY_POOL = 1024};
+
+/* calls per layer trial and blocks per chained block trial */
+enum{LAYER_CALLS = 1 << 16};
+enum{CHAIN_BLOCKS = 1 << 16};
+
+enum{FORMAT_CSV = 0, FORMAT_JSON = 1};
+
+typedef enum {
+    CALL_BATCHED,
+    CALL_SINGLE,
+    CALL_PER_BLOCK_KEY,
+    CALL_BATCHED_PER_BLOCK_KEY,
+    CALL_CTX_BATCHED,
+    CALL_CTX_SINGLE,
+    CALL_PMAC,
+    CALL_PMAC_THREADS,
+    CALL_CBC_MAC
+} benchcall_t;
+
+static const char* benchcall_names[] = {"batched", "single", "single", "batched",
+                                        "batched-ctx", "single-ctx", "pmac", "pmac-threads",
+                                        "cbc-mac"};
+static const char* benchkey_names[] = {"fixed", "fixed", "per-block", "per-block", "fixed",
+                                       "fixed", "fixed", "fixed", "fixed"};
+
+typedef struct bench {
+    const char* cipher;
+    const princev2ctx_t* ctx; /* for the ctx calls */
+    const princev2pmackey_t* pmacKey; /* for the MAC calls */
+    princeengine_t engine;
+    princemode_t mode;
+    benchcall_t call;
+    const princev2key_t* keys;
+    uint64_t* blocks;
+    size_t n;
+} bench_t;
+
+static int format = FORMAT_CSV;
+static int rows = 0;
+
+static double nanoseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* TSC ticks, or nanoseconds where there is no TSC */
+static double cycles() {
+#if BENCH_HAVE_RDTSC
+    return (double) __rdtsc();
+#else
+    return nanoseconds();
+#endif
+}
+
+/* parses a byte count with an optional K, M or G suffix.
+   returns 0 if no error */
+static int parseSize(const char* str, size_t* size) {
+    char* end;
+    unsigned long long value = strtoull(str, &end, 10);
+
+    switch (*end) {
+    case 'G': case 'g': value <<= 10; /* fall through */
+    case 'M': case 'm': value <<= 10; /* fall through */
+    case 'K': case 'k': value <<= 10; end++; break;
+    }
+
+    if (end == str || *end != '\0' || value < BLOCK_BYTES) {
+        fprintf(stderr, "failed to parse size %s\n", str);
+        return -1;
+    }
+
+    *size = value;
+    return 0;
+}
+
+static void printRow(const char* cipher, const char* implementation, const char* operation,
+                     const char* call, const char* keys, size_t blocks,
+                     double cyclesPerBlock, double nsPerBlock) {
+    double mbPerSecond = BLOCK_BYTES * 1e3 / nsPerBlock;
+
+    if (format == FORMAT_CSV) {
+        if (rows == 0) {
+            printf("cipher,implementation,operation,call,keys,blocks,bytes,"
+                   "cycles_per_block,cycles_per_byte,ns_per_block,mb_per_s\n");
+        }
+        printf("%s,%s,%s,%s,%s,%zu,%zu,%.2f,%.3f,%.2f,%.1f\n", cipher, implementation,
+               operation, call, keys, blocks, blocks * BLOCK_BYTES, cyclesPerBlock,
+               cyclesPerBlock / BLOCK_BYTES, nsPerBlock, mbPerSecond);
+    } else {
+        printf("%s{\"cipher\": \"%s\", \"implementation\": \"%s\", \"operation\": \"%s\", "
+               "\"call\": \"%s\", \"keys\": \"%s\", \"blocks\": %zu, \"bytes\": %zu, "
+               "\"cycles_per_block\": %.2f, \"cycles_per_byte\": %.3f, \"ns_per_block\": %.2f, "
+               "\"mb_per_s\": %.1f}",
+               rows == 0 ? "[\n  " : ",\n  ", cipher, implementation, operation, call, keys,
+               blocks, blocks * BLOCK_BYTES, cyclesPerBlock, cyclesPerBlock / BLOCK_BYTES,
+               nsPerBlock, mbPerSecond);
+    }
+
+    rows++;
+    fflush(stdout);
+}
+
+/* tags of the MAC calls end up here, so they are not optimized away */
+static volatile uint64_t macSink;
+
+/* the serial baseline for PMAC: CBC-MAC with the same 10..0 padding, every
+   block waiting for the latency of the one before on prince_encrypt_fast */
+static uint64_t cbcMac(princev2key_t key, const uint8_t* data, size_t len) {
+    uint64_t state = 0;
+
+    for (; len >= BLOCK_BYTES; data += BLOCK_BYTES, len -= BLOCK_BYTES) {
+        state = prince_encrypt_fast(key, state ^ loadBigEndian(data));
+    }
+
+    uint64_t last = (uint64_t) 0x80 << (8 * (BLOCK_BYTES - 1 - len));
+    for (size_t b = 0; b < len; b++) {
+        last |= (uint64_t) data[b] << (8 * (BLOCK_BYTES - 1 - b));
+    }
+
+    return prince_encrypt_fast(key, state ^ last);
+}
+
+static void runBench(const bench_t* bench) {
+    switch (bench->call) {
+    case CALL_BATCHED:
+        if (bench->mode == ENC) {
+            prince_engine_encrypt(bench->engine, bench->keys[0], bench->blocks,
+                                  bench->blocks, bench->n);
+        } else {
+            prince_engine_decrypt(bench->engine, bench->keys[0], bench->blocks,
+                                  bench->blocks, bench->n);
+        }
+        break;
+    case CALL_SINGLE:
+    case CALL_PER_BLOCK_KEY:
+        for (size_t i = 0; i < bench->n; i++) {
+            princev2key_t key = bench->keys[bench->call == CALL_SINGLE ? 0 : i % KEY_POOL];
+
+            if (bench->mode == ENC) {
+                prince_engine_encrypt(bench->engine, key, bench->blocks + i,
+                                      bench->blocks + i, 1);
+            } else {
+                prince_engine_decrypt(bench->engine, key, bench->blocks + i,
+                                      bench->blocks + i, 1);
+            }
+        }
+        break;
+    case CALL_BATCHED_PER_BLOCK_KEY:
+        for (size_t i = 0; i < bench->n; i += KEY_POOL) {
+            size_t count = bench->n - i < KEY_POOL ? bench->n - i : KEY_POOL;
+
+            if (bench->mode == ENC) {
+                prince_engine_encrypt_keys(bench->engine, bench->keys, bench->blocks + i,
+                                           bench->blocks + i, count);
+            } else {
+                prince_engine_decrypt_keys(bench->engine, bench->keys, bench->blocks + i,
+                                           bench->blocks + i, count);
+            }
+        }
+        break;
+    case CALL_CTX_BATCHED:
+        if (bench->mode == ENC) {
+            prince_engine_encrypt_ctx(bench->engine, bench->ctx, bench->blocks,
+                                      bench->blocks, bench->n);
+        } else {
+            prince_engine_decrypt_ctx(bench->engine, bench->ctx, bench->blocks,
+                                      bench->blocks, bench->n);
+        }
+        break;
+    case CALL_CTX_SINGLE:
+        for (size_t i = 0; i < bench->n; i++) {
+            if (bench->mode == ENC) {
+                prince_engine_encrypt_ctx(bench->engine, bench->ctx, bench->blocks + i,
+                                          bench->blocks + i, 1);
+            } else {
+                prince_engine_decrypt_ctx(bench->engine, bench->ctx, bench->blocks + i,
+                                          bench->blocks + i, 1);
+            }
+        }
+        break;
+    case CALL_PMAC:
+    case CALL_PMAC_THREADS:
+        macSink = prince_pmac(bench->pmacKey, (const uint8_t*) bench->blocks,
+                              bench->n * BLOCK_BYTES, bench->call == CALL_PMAC ? 1 : 0);
+        break;
+    case CALL_CBC_MAC:
+        macSink = cbcMac(bench->keys[0], (const uint8_t*) bench->blocks, bench->n * BLOCK_BYTES);
+        break;
+    }
+}
+
+static void measureBench(const bench_t* bench) {
+    size_t reps = bench->n < MIN_TRIAL_BLOCKS ? MIN_TRIAL_BLOCKS / bench->n : 1;
+    double bestCycles = 0, bestNs = 0, total = 0;
+
+    runBench(bench); /* warm up caches and the branch predictor */
+
+    for (int trial = 0; trial < MIN_TRIALS || total < MIN_CYCLES; trial++) {
+        double ns = nanoseconds();
+        double start = cycles();
+
+        for (size_t r = 0; r < reps; r++) {
+            runBench(bench);
+        }
+
+        double elapsed = cycles() - start;
+        ns = nanoseconds() - ns;
+
+        if (trial == 0 || elapsed < bestCycles) {
+            bestCycles = elapsed;
+            bestNs = ns;
+        }
+        total += elapsed;
+
+        if (trial == 0 && elapsed >= MIN_CYCLES) {
+            break;
+        }
+    }
+
+    double blocks = (double) reps * bench->n;
+    const char* operation = bench->call >= CALL_PMAC ? "mac"
+                            : bench->mode == ENC ? "encrypt" : "decrypt";
+    /* cbcMac runs on prince_encrypt_fast whatever the engine */
+    const char* implementation = bench->call == CALL_CBC_MAC ? "fast"
+                                 : prince_engine_name(bench->engine);
+    printRow(bench->cipher, implementation, operation,
+             benchcall_names[bench->call], benchkey_names[bench->call], bench->n,
+             bestCycles / blocks, bestNs / blocks);
+}
+
+static void measureEngine(princeengine_t engine, const princev2key_t* keys,
+                          uint64_t* blocks, size_t maxBlocks) {
+    princev2ctx_t ctx[2];
+    const char* ciphers[2] = {"princev2", "prince"};
+
+    prince_ctx_init(&ctx[0], keys[0]);
+    prince_v1_ctx_init(&ctx[1], keys[0]);
+
+    for (size_t n = 1; ; n = n * 8 < maxBlocks ? n * 8 : maxBlocks) {
+        for (benchcall_t call = CALL_BATCHED; call <= CALL_BATCHED_PER_BLOCK_KEY; call++) {
+            for (princemode_t mode = ENC; mode <= DEC; mode++) {
+                bench_t bench = {.cipher = ciphers[0], .ctx = NULL, .engine = engine,
+                                 .mode = mode, .call = call, .keys = keys,
+                                 .blocks = blocks, .n = n};
+                measureBench(&bench);
+            }
+        }
+
+        for (benchcall_t call = CALL_CTX_BATCHED; call <= CALL_CTX_SINGLE; call++) {
+            for (princemode_t mode = ENC; mode <= DEC; mode++) {
+                for (int c = 0; c < 2; c++) {
+                    bench_t bench = {.cipher = ciphers[c], .ctx = &ctx[c], .engine = engine,
+                                     .mode = mode, .call = call, .keys = keys,
+                                     .blocks = blocks, .n = n};
+                    measureBench(&bench);
+                }
+            }
+        }
+
+        if (n == maxBlocks) {
+            break;
+        }
+    }
+}
+
+/* PMAC on the engine picked for PRINCE_ENGINE_AUTO, with one and with all
+   threads, and the CBC-MAC baseline, for a cache line, a 4K page and the
+   whole buffer */
+static void measureMacs(const princev2key_t* keys, uint64_t* blocks, size_t maxBlocks) {
+    size_t sizes[] = {8, 512, maxBlocks};
+    princev2pmackey_t pmacKey;
+
+    prince_pmac_key(&pmacKey, keys[0]);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        if (sizes[s] > maxBlocks || (s > 0 && sizes[s] == sizes[s - 1])) {
+            continue;
+        }
+
+        for (benchcall_t call = CALL_PMAC; call <= CALL_CBC_MAC; call++) {
+            bench_t bench = {.cipher = "princev2", .ctx = NULL, .pmacKey = &pmacKey,
+                             .engine = prince_engine_get(), .mode = ENC, .call = call,
+                             .keys = keys, .blocks = blocks, .n = sizes[s]};
+            measureBench(&bench);
+        }
+    }
+}
+
+/* runs state through calls dependent steps and returns the last state */
+typedef uint64_t (*benchchain_t)(uint64_t state, int calls);
+
+/* fastest of MIN_TRIALS chains of calls steps */
+static void measureChain(const char* cipher, const char* implementation,
+                         const char* operation, const char* keys, benchchain_t chain,
+                         int calls) {
+    double bestCycles = 0, bestNs = 0;
+    volatile uint64_t sink;
+
+    for (int trial = 0; trial < MIN_TRIALS; trial++) {
+        double ns = nanoseconds();
+        double start = cycles();
+
+        uint64_t state = chain(0x0123456789abcdef, calls);
+
+        double elapsed = cycles() - start;
+        ns = nanoseconds() - ns;
+        sink = state;
+
+        if (trial == 0 || elapsed < bestCycles) {
+            bestCycles = elapsed;
+            bestNs = ns;
+        }
+    }
+    (void) sink;
+
+    printRow(cipher, implementation, operation, "chained", keys, 1, bestCycles / calls,
+             bestNs / calls);
+}
+
+static uint64_t (*chainLayerFn)(uint64_t state);
+
+static uint64_t chainLayer(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = chainLayerFn(state);
+    }
+
+    return state;
+}
+
+/* latency of one layer as a chain of dependent calls */
+static void measureLayer(const char* name, uint64_t (*layer)(uint64_t state)) {
+    chainLayerFn = layer;
+    measureChain("both", "reference", name, "none", chainLayer, LAYER_CALLS);
+}
+
+static uint64_t layerSbox(uint64_t state) {
+    return prince_s_layer(state, prince_sbox);
+}
+
+static uint64_t layerSboxInverse(uint64_t state) {
+    return prince_s_layer(state, prince_sbox_inverse);
+}
+
+static uint64_t layerKeyAddition(uint64_t state) {
+    return state ^ RCs[1];
+}
+
+static void measureLayers() {
+    measureLayer("s_layer", layerSbox);
+    measureLayer("s_inverse_layer", layerSboxInverse);
+    measureLayer("m_layer", prince_m_layer);
+    measureLayer("shiftRow", prince_shiftRow);
+    measureLayer("shiftRowInverse", prince_shiftRowInverse);
+    measureLayer("key_addition", layerKeyAddition);
+}
+
+/* key and ctxs of the chained block rows */
+static princev2key_t chainKey;
+static princev2ctx_t chainCtx;
+static princev2ctx_t chainV1Ctx;
+
+static uint64_t chainEncrypt(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_encrypt(chainKey, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainDecrypt(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_decrypt(chainKey, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainEncryptCtx(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_encrypt_ctx(&chainCtx, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainDecryptCtx(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_decrypt_ctx(&chainCtx, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainEncryptFast(uint64_t state, int calls) {
+    princev2key_t key = chainKey;
+
+    for (int i = 0; i < calls; i++) {
+        state = prince_encrypt_fast(key, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainDecryptFast(uint64_t state, int calls) {
+    princev2key_t key = chainKey;
+
+    for (int i = 0; i < calls; i++) {
+        state = prince_decrypt_fast(key, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainEncryptV1(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_v1_encrypt(chainKey, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainDecryptV1(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_v1_decrypt(chainKey, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainEncryptV1Ctx(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_encrypt_ctx(&chainV1Ctx, state);
+    }
+
+    return state;
+}
+
+static uint64_t chainDecryptV1Ctx(uint64_t state, int calls) {
+    for (int i = 0; i < calls; i++) {
+        state = prince_decrypt_ctx(&chainV1Ctx, state);
+    }
+
+    return state;
+}
+
+/* latency of a whole block, every ciphertext being the next plaintext,
+   for PRINCEv2 and the original PRINCE */
+static void measureChains(princev2key_t key) {
+    chainKey = key;
+    prince_ctx_init(&chainCtx, key);
+    prince_v1_ctx_init(&chainV1Ctx, key);
+
+    measureChain("princev2", "reference", "encrypt", "fixed", chainEncrypt, CHAIN_BLOCKS);
+    measureChain("princev2", "reference", "decrypt", "fixed", chainDecrypt, CHAIN_BLOCKS);
+    measureChain("princev2", "reference-ctx", "encrypt", "fixed", chainEncryptCtx,
+                 CHAIN_BLOCKS);
+    measureChain("princev2", "reference-ctx", "decrypt", "fixed", chainDecryptCtx,
+                 CHAIN_BLOCKS);
+    measureChain("princev2", "fast", "encrypt", "fixed", chainEncryptFast, CHAIN_BLOCKS);
+    measureChain("princev2", "fast", "decrypt", "fixed", chainDecryptFast, CHAIN_BLOCKS);
+
+    measureChain("prince", "reference", "encrypt", "fixed", chainEncryptV1, CHAIN_BLOCKS);
+    measureChain("prince", "reference", "decrypt", "fixed", chainDecryptV1, CHAIN_BLOCKS);
+    measureChain("prince", "reference-ctx", "encrypt", "fixed", chainEncryptV1Ctx,
+                 CHAIN_BLOCKS);
+    measureChain("prince", "reference-ctx", "decrypt", "fixed", chainDecryptV1Ctx,
+                 CHAIN_BLOCKS);
+}
+
+int main(int argc, char* argv[]) {
+    size_t maxBytes = DEFAULT_MAX_BYTES;
+    princeengine_t only = PRINCE_ENGINE_AUTO;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            format = FORMAT_JSON;
+        } else if (!strcmp(argv[i], "--csv")) {
+            format = FORMAT_CSV;
+        } else if (!strcmp(argv[i], "--max-bytes") && i + 1 < argc) {
+            if (parseSize(argv[++i], &maxBytes) != 0) {
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "--engine") && i + 1 < argc) {
+            if (prince_engine_fromName(argv[++i], &only) != 0 ||
+                !prince_engine_supported(only)) {
+                fprintf(stderr, "%s: engine %s not available\n", argv[0], argv[i]);
+                return -1;
+            }
+        } else {
+            fprintf(stderr,
+                    "Usage: %s [--csv|--json] [--engine name] [--max-bytes size[K|M|G]]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+
+    size_t maxBlocks = maxBytes / BLOCK_BYTES;
+    uint64_t* blocks = malloc(maxBlocks * sizeof(uint64_t));
+    princev2key_t* keys = malloc(KEY_POOL * sizeof(princev2key_t));
+    if (blocks == NULL || keys == NULL) {
+        fprintf(stderr, "%s: cannot allocate %zu bytes\n", argv[0], maxBytes);
+        return -1;
+    }
+
+    prng_fill(prng_thread(), blocks, maxBlocks);
+    for (int i = 0; i < KEY_POOL; i++) {
+        keys[i] = key_newRandom();
+    }
+
+    fprintf(stderr, "%s: cycles are %s\n", argv[0],
+            BENCH_HAVE_RDTSC ? "TSC ticks" : "nanoseconds");
+
+    if (only == PRINCE_ENGINE_AUTO || only == PRINCE_ENGINE_REFERENCE) {
+        measureLayers();
+        measureChains(keys[0]);
+    }
+
+    for (princeengine_t engine = PRINCE_ENGINE_REFERENCE; engine < NUM_OF_ENGINES; engine++) {
+        if ((only != PRINCE_ENGINE_AUTO && engine != only) ||
+            !prince_engine_supported(engine)) {
+            continue;
+        }
+
+        measureEngine(engine, keys, blocks, maxBlocks);
+    }
+
+    if (only != PRINCE_ENGINE_AUTO) {
+        prince_engine_set(only);
+    }
+    measureMacs(keys, blocks, maxBlocks);
+
+    if (format == FORMAT_JSON) {
+        printf(rows == 0 ? "[]\n" : "\n]\n");
+    }
+
+    free(keys);
+    free(blocks);
+    return 0;
+}
@@ -0,0 +1,367 @@
+/**
+princev2bitslice.c
+
+64-way bitsliced implementation of PRINCEv2
+
+64 blocks are transposed into 64 bit-planes, plane b holding bit b of every
+block. The S-box is then evaluated as a boolean circuit on the four planes
+of each nibble, while M' and SR only move and XOR whole planes. All 64
+blocks are processed with the same instruction stream, so the engine runs
+in constant time.
+
+The plane of bit t (t = 0 is the least significant bit) of nibble i
+(i = 0 is the most significant nibble, as in block_getNibble) is
+4 * (15 - i) + t.
+**/
+
+#include <assert.h>
+#include <string.h>
+
+#include "princev2bitslice.h"
+#include "princev2.h"
+#include "block.h"
+
+static const char prince_bitslice_identity[NUM_OF_NIBBLES] = {
+     0,  1,  2,  3,
+     4,  5,  6,  7,
+     8,  9, 10, 11,
+    12, 13, 14, 15
+};
+
+static inline int prince_bitslice_plane(int nibble, int bit) {
+    return NIBBLE_SIZE * (NUM_OF_NIBBLES - 1 - nibble) + bit;
+}
+
+void prince_bitslice_transpose(uint64_t planes[BITSLICE_WIDTH]) {
+    uint64_t mask = 0x00000000ffffffff;
+
+    for (int width = 32; width != 0; width >>= 1, mask ^= mask << width) {
+        for (int k = 0; k < BITSLICE_WIDTH; k = ((k | width) + 1) & ~width) {
+            uint64_t t = ((planes[k] >> width) ^ planes[k | width]) & mask;
+            planes[k] ^= t << width;
+            planes[k | width] ^= t;
+        }
+    }
+}
+
+/* every plane becomes all ones where the corresponding bit of word is set */
+static void prince_bitslice_expand(uint64_t word, uint64_t planes[BITSLICE_WIDTH]) {
+    for (int b = 0; b < BITSLICE_WIDTH; b++) {
+        planes[b] = -((word >> b) & 1);
+    }
+}
+
+static inline void prince_bitslice_xor(uint64_t state[BITSLICE_WIDTH],
+                                       const uint64_t key[BITSLICE_WIDTH]) {
+    for (int b = 0; b < BITSLICE_WIDTH; b++) {
+        state[b] ^= key[b];
+    }
+}
+
+/* algebraic normal form of prince_sbox, sharing the products */
+static void prince_bitslice_s_layer(uint64_t state[BITSLICE_WIDTH]) {
+    for (int b = 0; b < BITSLICE_WIDTH; b += NIBBLE_SIZE) {
+        uint64_t x0 = state[b], x1 = state[b + 1], x2 = state[b + 2], x3 = state[b + 3];
+
+        uint64_t x01 = x0 & x1, x02 = x0 & x2, x03 = x0 & x3;
+        uint64_t x12 = x1 & x2, x13 = x1 & x3, x23 = x2 & x3;
+        uint64_t x012 = x01 & x2, x013 = x01 & x3, x023 = x02 & x3, x123 = x12 & x3;
+
+        state[b]     = ~(x01 ^ x2 ^ x12 ^ x012 ^ x3 ^ x03 ^ x23);
+        state[b + 1] = ~(x02 ^ x12 ^ x012 ^ x13 ^ x123);
+        state[b + 2] = x0 ^ x01 ^ x3 ^ x03 ^ x13 ^ x013 ^ x123;
+        state[b + 3] = ~(x1 ^ x12 ^ x012 ^ x3 ^ x013 ^ x23 ^ x023);
+    }
+}
+
+/* algebraic normal form of prince_sbox_inverse */
+static void prince_bitslice_s_layer_inverse(uint64_t state[BITSLICE_WIDTH]) {
+    for (int b = 0; b < BITSLICE_WIDTH; b += NIBBLE_SIZE) {
+        uint64_t x0 = state[b], x1 = state[b + 1], x2 = state[b + 2], x3 = state[b + 3];
+
+        uint64_t x01 = x0 & x1, x02 = x0 & x2;
+        uint64_t x12 = x1 & x2, x13 = x1 & x3, x23 = x2 & x3;
+        uint64_t x012 = x01 & x2, x013 = x01 & x3, x023 = x02 & x3, x123 = x12 & x3;
+
+        state[b]     = ~(x01 ^ x12 ^ x3 ^ x013 ^ x23 ^ x023);
+        state[b + 1] = ~(x02 ^ x12 ^ x012 ^ x13 ^ x23);
+        state[b + 2] = x0 ^ x01 ^ x2 ^ x02 ^ x12 ^ x012 ^ x13 ^ x013;
+        state[b + 3] = ~(x0 ^ x1 ^ x01 ^ x02 ^ x12 ^ x012 ^ x23 ^ x023 ^ x123);
+    }
+}
+
+/* M' layer with nibble permutations folded into the wiring: nibble j of
+   the input to M' is read from nibble inPerm[j] of in, and nibble j of the
+   output of M' is written to nibble outPerm[j] of out.
+
+   Every row of M0..M3 has exactly one zero on the diagonal, so each output
+   bit of a column is the parity of the four input bits at the same position
+   minus the one that hits the zero. */
+static void prince_bitslice_m_layer(const uint64_t in[BITSLICE_WIDTH],
+                                    uint64_t out[BITSLICE_WIDTH],
+                                    const char inPerm[NUM_OF_NIBBLES],
+                                    const char outPerm[NUM_OF_NIBBLES]) {
+    for (int column = 0; column < 4; column++) {
+        /* MHat1 is used for the two middle columns, MHat0 otherwise */
+        int hat = (column == 1 || column == 2);
+
+        for (int bit = 0; bit < NIBBLE_SIZE; bit++) {
+            uint64_t n[4];
+            for (int s = 0; s < 4; s++) {
+                n[s] = in[prince_bitslice_plane(inPerm[4*column + s], bit)];
+            }
+            uint64_t parity = n[0] ^ n[1] ^ n[2] ^ n[3];
+
+            for (int r = 0; r < 4; r++) {
+                int zero = (3 - bit - r - hat + 8) % 4;
+                out[prince_bitslice_plane(outPerm[4*column + r], bit)] = parity ^ n[zero];
+            }
+        }
+    }
+}
+
+/* the whitening and forward rounds 1..forward. Called with a constant the
+   loop is unrolled */
+static inline __attribute__((always_inline))
+void prince_bitslice_forward(const uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH],
+                             uint64_t state[BITSLICE_WIDTH], const int forward) {
+    uint64_t tmp[BITSLICE_WIDTH];
+
+    prince_bitslice_xor(state, keys[0]);
+
+    /* SR(M'(x)): nibble j of the M' output goes to position shift_inverse[j] */
+#pragma GCC unroll 8
+    for (int i = 1; i <= forward; i++) {
+        prince_bitslice_s_layer(state);
+        prince_bitslice_m_layer(state, tmp, prince_bitslice_identity, prince_shift_inverse);
+        memcpy(state, tmp, sizeof(tmp));
+        prince_bitslice_xor(state, keys[i]);
+    }
+}
+
+static inline __attribute__((always_inline))
+void prince_bitslice_middle(const uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH],
+                            uint64_t state[BITSLICE_WIDTH]) {
+    uint64_t tmp[BITSLICE_WIDTH];
+
+    prince_bitslice_s_layer(state);
+    prince_bitslice_xor(state, keys[NUM_OF_ROUNDS / 2]);
+    prince_bitslice_m_layer(state, tmp, prince_bitslice_identity, prince_bitslice_identity);
+    memcpy(state, tmp, sizeof(tmp));
+    prince_bitslice_xor(state, keys[NUM_OF_ROUNDS / 2 + 1]);
+    prince_bitslice_s_layer_inverse(state);
+}
+
+/* inverse rounds 11 - backward..10 and the final whitening. Inverse round i
+   of prince_core adds key i + 2 */
+static inline __attribute__((always_inline))
+void prince_bitslice_backward(const uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH],
+                              uint64_t state[BITSLICE_WIDTH], const int backward) {
+    uint64_t tmp[BITSLICE_WIDTH];
+
+    /* M'(SR^-1(x)): nibble j of the M' input is nibble shift_inverse[j] */
+#pragma GCC unroll 8
+    for (int i = NUM_OF_ROUNDS - 1 - backward; i < NUM_OF_ROUNDS - 1; i++) {
+        prince_bitslice_xor(state, keys[i + 2]);
+        prince_bitslice_m_layer(state, tmp, prince_shift_inverse, prince_bitslice_identity);
+        memcpy(state, tmp, sizeof(tmp));
+        prince_bitslice_s_layer_inverse(state);
+    }
+
+    prince_bitslice_xor(state, keys[NUM_OF_KEY_ADDITIONS - 1]);
+}
+
+static void prince_bitslice_core(const uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH],
+                                 uint64_t state[BITSLICE_WIDTH]) {
+    prince_bitslice_forward(keys, state, NUM_OF_FORWARD_ROUNDS);
+    prince_bitslice_middle(keys, state);
+    prince_bitslice_backward(keys, state, NUM_OF_INVERSE_ROUNDS);
+}
+
+typedef void (*bitslicepart_t)(const uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH],
+                               uint64_t state[BITSLICE_WIDTH]);
+
+/* one unrolled forward and backward part per round count 0..5, for the
+   reduced-round cores */
+#define BITSLICE_ROUNDS_EACH(X) X(0) X(1) X(2) X(3) X(4) X(5)
+
+#define BITSLICE_ROUNDS_DEFINE(r) \
+    static void prince_bitslice_forward_ ## r( \
+            const uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH], \
+            uint64_t state[BITSLICE_WIDTH]) { \
+        prince_bitslice_forward(keys, state, r); \
+    } \
+    static void prince_bitslice_backward_ ## r( \
+            const uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH], \
+            uint64_t state[BITSLICE_WIDTH]) { \
+        prince_bitslice_backward(keys, state, r); \
+    }
+#define BITSLICE_ROUNDS_FORWARD(r) prince_bitslice_forward_ ## r,
+#define BITSLICE_ROUNDS_BACKWARD(r) prince_bitslice_backward_ ## r,
+
+BITSLICE_ROUNDS_EACH(BITSLICE_ROUNDS_DEFINE)
+
+static const bitslicepart_t prince_bitslice_forwards[] = {
+    BITSLICE_ROUNDS_EACH(BITSLICE_ROUNDS_FORWARD)
+};
+
+static const bitslicepart_t prince_bitslice_backwards[] = {
+    BITSLICE_ROUNDS_EACH(BITSLICE_ROUNDS_BACKWARD)
+};
+
+#undef BITSLICE_ROUNDS_EACH
+#undef BITSLICE_ROUNDS_DEFINE
+#undef BITSLICE_ROUNDS_FORWARD
+#undef BITSLICE_ROUNDS_BACKWARD
+
+/* expands every key addition of prince_core into 64 planes */
+static void prince_bitslice_keys(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH]) {
+    for (int k = 0; k < NUM_OF_KEY_ADDITIONS; k++) {
+        prince_bitslice_expand(rk[k], keys[k]);
+    }
+}
+
+static void prince_bitslice_blocks(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                   const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH];
+    uint64_t state[BITSLICE_WIDTH];
+
+    prince_bitslice_keys(rk, keys);
+
+    while (n > 0) {
+        size_t count = n < BITSLICE_WIDTH ? n : BITSLICE_WIDTH;
+
+        /* the unused lanes of a partial batch are zero */
+        memset(state, 0, sizeof(state));
+        memcpy(state, in, count * sizeof(uint64_t));
+
+        prince_bitslice_transpose(state);
+        prince_bitslice_core(keys, state);
+        prince_bitslice_transpose(state);
+
+        memcpy(out, state, count * sizeof(uint64_t));
+
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
+
+/* one key per lane: the key words of 64 blocks are transposed like the
+   blocks, so every key addition is a key word plane XOR a constant */
+static void prince_bitslice_keysBlocks(princemode_t mode, const princev2key_t* keys,
+                                       const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t constant[NUM_OF_KEY_ADDITIONS];
+    int word[NUM_OF_KEY_ADDITIONS];
+    uint64_t constants[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH];
+    uint64_t rk[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH];
+    uint64_t words[2][BITSLICE_WIDTH];
+    uint64_t state[BITSLICE_WIDTH];
+
+    prince_roundKeyWords(mode, constant, word);
+    prince_bitslice_keys(constant, constants);
+
+    while (n > 0) {
+        size_t count = n < BITSLICE_WIDTH ? n : BITSLICE_WIDTH;
+
+        /* the unused lanes of a partial batch are zero */
+        memset(state, 0, sizeof(state));
+        memset(words, 0, sizeof(words));
+        memcpy(state, in, count * sizeof(uint64_t));
+        for (size_t i = 0; i < count; i++) {
+            words[0][i] = keys[i].k0;
+            words[1][i] = keys[i].k1;
+        }
+
+        prince_bitslice_transpose(words[0]);
+        prince_bitslice_transpose(words[1]);
+        for (int k = 0; k < NUM_OF_KEY_ADDITIONS; k++) {
+            for (int b = 0; b < BITSLICE_WIDTH; b++) {
+                rk[k][b] = words[word[k]][b] ^ constants[k][b];
+            }
+        }
+
+        prince_bitslice_transpose(state);
+        prince_bitslice_core(rk, state);
+        prince_bitslice_transpose(state);
+
+        memcpy(out, state, count * sizeof(uint64_t));
+
+        keys += count;
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
+
+void prince_encrypt_bitslice(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+
+    prince_roundKeys(key, ENC, rk);
+    prince_bitslice_blocks(rk, in, out, n);
+}
+
+void prince_decrypt_bitslice(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+
+    prince_roundKeys(key_new(key.k1^BETA, key.k0^ALPHA), DEC, rk);
+    prince_bitslice_blocks(rk, in, out, n);
+}
+
+void prince_encrypt_bitslice_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n) {
+    prince_bitslice_blocks(ctx->enc, in, out, n);
+}
+
+void prince_decrypt_bitslice_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n) {
+    prince_bitslice_blocks(ctx->dec, in, out, n);
+}
+
+void prince_encrypt_keys_bitslice(const princev2key_t* keys, const uint64_t* in,
+                                  uint64_t* out, size_t n) {
+    prince_bitslice_keysBlocks(ENC, keys, in, out, n);
+}
+
+void prince_decrypt_keys_bitslice(const princev2key_t* keys, const uint64_t* in,
+                                  uint64_t* out, size_t n) {
+    prince_bitslice_keysBlocks(DEC, keys, in, out, n);
+}
+
+void prince_encrypt_bitslice_rounds(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                    int forward, int middle, int backward,
+                                    const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t keys[NUM_OF_KEY_ADDITIONS][BITSLICE_WIDTH];
+    uint64_t state[BITSLICE_WIDTH];
+
+    assert(forward >= 0 && forward <= NUM_OF_FORWARD_ROUNDS);
+    assert(backward >= 0 && backward <= NUM_OF_INVERSE_ROUNDS);
+
+    bitslicepart_t forwardPart = prince_bitslice_forwards[forward];
+    bitslicepart_t backwardPart = prince_bitslice_backwards[backward];
+
+    prince_bitslice_keys(rk, keys);
+
+    while (n > 0) {
+        size_t count = n < BITSLICE_WIDTH ? n : BITSLICE_WIDTH;
+
+        /* the unused lanes of a partial batch are zero */
+        memset(state, 0, sizeof(state));
+        memcpy(state, in, count * sizeof(uint64_t));
+
+        prince_bitslice_transpose(state);
+        forwardPart(keys, state);
+        if (middle) {
+            prince_bitslice_middle(keys, state);
+        }
+        backwardPart(keys, state);
+        prince_bitslice_transpose(state);
+
+        memcpy(out, state, count * sizeof(uint64_t));
+
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
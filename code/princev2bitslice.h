@@ -0,0 +1,45 @@
+/**
+princev2bitslice.h
+
+Interface for the 64-way bitsliced PRINCEv2 engine
+**/
+
+#ifndef _PRINCE_BITSLICE_
+#define _PRINCE_BITSLICE_
+
+#include <stddef.h>
+
+#include "key.h"
+#include "princev2.h"
+
+/* number of blocks processed in parallel, one per bit of a plane */
+enum {BITSLICE_WIDTH = 64};
+
+/* transposes a 64x64 bit matrix in place: afterwards bit r of plane[b]
+   is bit b of block[r] and vice versa */
+void prince_bitslice_transpose(uint64_t planes[BITSLICE_WIDTH]);
+
+/* encrypts/decrypts n blocks from in to out under one key, 64 at a time.
+   in and out may be the same array */
+void prince_encrypt_bitslice(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+void prince_decrypt_bitslice(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+
+/* same with a key expanded by prince_ctx_init */
+void prince_encrypt_bitslice_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n);
+void prince_decrypt_bitslice_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n);
+
+/* one key per block, in[i] goes through keys[i] */
+void prince_encrypt_keys_bitslice(const princev2key_t* keys, const uint64_t* in,
+                                  uint64_t* out, size_t n);
+void prince_decrypt_keys_bitslice(const princev2key_t* keys, const uint64_t* in,
+                                  uint64_t* out, size_t n);
+
+/* prince_core_rounds on n blocks under the key list rk, with an unrolled
+   part for every number of forward and of backward rounds */
+void prince_encrypt_bitslice_rounds(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                    int forward, int middle, int backward,
+                                    const uint64_t* in, uint64_t* out, size_t n);
+
+#endif
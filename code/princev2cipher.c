@@ -1,7 +1,8 @@
 /**
 princev2cipher.c
 
-This program uses a 128-bit key to encrypt or decrypt a 64-bit text
+This program uses a 128-bit key to encrypt or decrypt a 64-bit text, or
+a whole file
 
 Sample Usage:
 
@@ -11,35 +12,593 @@ To encrypt:
 To decrypt:
 > princev2cipher D k0 k1 c
 
+To encrypt/decrypt many blocks, one "k0 k1 m" line (or one "m" line
+under a fixed key) per block from stdin, one result line per block to stdout:
+> princev2cipher --batch E < vectors.txt
+> princev2cipher --batch E k0 k1 < plaintexts.txt
+
+To encrypt/decrypt a file ("-" is stdin/stdout):
+> princev2cipher --file E k0 k1 plain.bin cipher.bin
+> princev2cipher --file D k0 k1 cipher.bin plain.bin
+
+To encrypt/decrypt a disk image sector by sector in the XTS-like mode of
+princev2xts.h, with data key k0 k1 and tweak key t0 t1 (sectors of 512
+bytes numbered from 0 by default, all cores):
+> princev2cipher --xts E k0 k1 t0 t1 disk.img disk.enc [--sector 4096] [--first n]
+      [--threads T]
+> princev2cipher --xts D k0 k1 t0 t1 disk.enc disk.img
+
+Files are processed as a sequence of 64-bit blocks, most significant byte
+first. Encryption pads the input to whole blocks with n bytes of value n
+(1 <= n <= 8, a full block of padding if the input is already a multiple of
+8 bytes), decryption checks and removes the padding. The --xts mode needs
+no padding: ciphertext has the length of the plaintext, a last sector
+shorter than the others is fine as long as it has at least 8 bytes.
+
 Sample build:
 > make princev2cipher
 **/
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "hex.h"
 #include "key.h"
+#include "misc.h"
 #include "princev2.h"
+#include "princev2xts.h"
 
 enum{ENCRYPT = 0, DECRYPT = 1};
 
+enum{BLOCK_BYTES = sizeof(uint64_t)};
+
+/* blocks per read/write in file mode */
+enum{FILE_CHUNK_BLOCKS = 1 << 17};
+
+/* batch mode: lines per engine call, bytes per read and longest line */
+enum{BATCH_BLOCKS = 4096};
+enum{BATCH_READ_BYTES = 1 << 16};
+enum{BATCH_MAX_LINE = 256};
+
+/* consecutive lines with the same key shorter than this are not worth an
+   expanded key and go through the multi-key engine with their neighbours */
+enum{BATCH_MIN_RUN = 32};
+
+/* parses a hex value, name is used in the error message.
+   returns 0 if no error */
+static int parseHex(const char* name, const char* str, uint64_t* value) {
+    char *checkptr;
+
+    *value = strtoul(str, &checkptr, 16);
+    if (*checkptr != '\0' || *str == '\0') {
+        fprintf(stderr, "failed to parse %s = %s from %s on\n", name, str, checkptr);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* parses a decimal value, name is used in the error message.
+   returns 0 if no error */
+static int parseDecimal(const char* name, const char* str, uint64_t* value) {
+    char *checkptr;
+
+    *value = strtoull(str, &checkptr, 10);
+    if (*checkptr != '\0' || *str == '\0') {
+        fprintf(stderr, "failed to parse %s = %s\n", name, str);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* parses E/D, returns -1 for anything else */
+static int parseMode(const char* str) {
+    if (!strcmp(str, "E")) {
+        return ENCRYPT;
+    } else if (!strcmp(str, "D")) {
+        return DECRYPT;
+    }
+
+    return -1;
+}
+
+/* reads until buffer is full or the input ends, returns bytes read or -1 */
+static ssize_t readFull(int fd, uint8_t* buffer, size_t len) {
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t got = read(fd, buffer + done, len - done);
+        if (got < 0) {
+            return -1;
+        }
+        if (got == 0) {
+            break;
+        }
+        done += got;
+    }
+
+    return done;
+}
+
+static int writeFull(int fd, const uint8_t* buffer, size_t len) {
+    while (len > 0) {
+        ssize_t put = write(fd, buffer, len);
+        if (put < 0) {
+            return -1;
+        }
+        buffer += put;
+        len -= put;
+    }
+
+    return 0;
+}
+
+/* en-/decrypts len bytes of buffer in place, len is a multiple of 8 */
+static void cryptChunk(int mode, princev2key_t key, uint8_t* buffer, uint64_t* blocks,
+                       size_t len) {
+    size_t n = len / BLOCK_BYTES;
+
+    for (size_t i = 0; i < n; i++) {
+        blocks[i] = loadBigEndian(buffer + i * BLOCK_BYTES);
+    }
+
+    if (mode == ENCRYPT) {
+        prince_encrypt_blocks(key, blocks, blocks, n);
+    } else {
+        prince_decrypt_blocks(key, blocks, blocks, n);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        storeBigEndian(buffer + i * BLOCK_BYTES, blocks[i]);
+    }
+}
+
+/* streams in through the batch engine into out, one chunk at a time.
+   Decryption holds back the last block of every chunk, since only the last
+   block of the file carries the padding. returns 0 if no error */
+static int cryptStream(int mode, princev2key_t key, int in, int out) {
+    size_t chunk = FILE_CHUNK_BLOCKS * BLOCK_BYTES;
+    uint8_t* buffer = malloc(chunk + BLOCK_BYTES);
+    uint64_t* blocks = malloc(chunk + BLOCK_BYTES);
+    size_t pending = 0; /* bytes held back from the previous chunk */
+    int status = -1;
+
+    if (buffer == NULL || blocks == NULL) {
+        fprintf(stderr, "cryptStream: out of memory\n");
+        goto done;
+    }
+
+    for (;;) {
+        ssize_t got = readFull(in, buffer + pending, chunk);
+        if (got < 0) {
+            perror("read");
+            goto done;
+        }
+
+        size_t len = pending + got;
+        int last = (size_t) got < chunk;
+
+        if (mode == ENCRYPT) {
+            if (last) {
+                size_t pad = BLOCK_BYTES - len % BLOCK_BYTES;
+                memset(buffer + len, (int) pad, pad);
+                len += pad;
+            }
+
+            cryptChunk(mode, key, buffer, blocks, len);
+            if (writeFull(out, buffer, len) != 0) {
+                perror("write");
+                goto done;
+            }
+        } else {
+            if (len % BLOCK_BYTES != 0 || (last && len == 0)) {
+                fprintf(stderr, "cryptStream: ciphertext is not a positive multiple of %d bytes\n",
+                        BLOCK_BYTES);
+                goto done;
+            }
+
+            /* the held back block is already decrypted */
+            cryptChunk(mode, key, buffer + pending, blocks, len - pending);
+
+            if (last) {
+                size_t pad = buffer[len - 1];
+                int valid = pad >= 1 && pad <= BLOCK_BYTES;
+
+                for (size_t i = 1; valid && i <= pad; i++) {
+                    valid = buffer[len - i] == pad;
+                }
+                if (!valid) {
+                    fprintf(stderr, "cryptStream: invalid padding\n");
+                    goto done;
+                }
+                len -= pad;
+            } else {
+                len -= BLOCK_BYTES;
+            }
+
+            if (writeFull(out, buffer, len) != 0) {
+                perror("write");
+                goto done;
+            }
+
+            memmove(buffer, buffer + len, BLOCK_BYTES);
+            pending = BLOCK_BYTES;
+        }
+
+        if (last) {
+            break;
+        }
+    }
+
+    status = 0;
+
+done:
+    free(buffer);
+    free(blocks);
+    return status;
+}
+
+/* princev2cipher --file {E/D} k0 k1 in out */
+static int fileMode(int argc, char* argv[]) {
+    if (argc != 7 || parseMode(argv[2]) < 0) {
+        fprintf(stderr, "Usage: %s --file {E/D} k0 k1 in out\n", argv[0]);
+        return -1;
+    }
+
+    uint64_t k0, k1;
+    if (parseHex("k0", argv[3], &k0) != 0 || parseHex("k1", argv[4], &k1) != 0) {
+        return -1;
+    }
+
+    int in = strcmp(argv[5], "-") ? open(argv[5], O_RDONLY) : STDIN_FILENO;
+    if (in < 0) {
+        perror(argv[5]);
+        return -1;
+    }
+
+    int out = strcmp(argv[6], "-") ? open(argv[6], O_WRONLY | O_CREAT | O_TRUNC, 0644)
+                                   : STDOUT_FILENO;
+    if (out < 0) {
+        perror(argv[6]);
+        close(in);
+        return -1;
+    }
+
+    int status = cryptStream(parseMode(argv[2]), key_new(k0, k1), in, out);
+
+    close(in);
+    if (close(out) != 0 && status == 0) {
+        perror(argv[6]);
+        status = -1;
+    }
+
+    return status;
+}
+
+/* streams in through the sector mode into out, FILE_CHUNK_BLOCKS blocks
+   rounded down to whole sectors at a time. returns 0 if no error */
+static int xtsStream(int mode, const princev2xts_t* xts, uint64_t sector, size_t sectorBytes,
+                     int threads, int in, int out) {
+    size_t sectors = FILE_CHUNK_BLOCKS * BLOCK_BYTES / sectorBytes;
+    size_t chunk = (sectors > 0 ? sectors : 1) * sectorBytes;
+    uint8_t* buffer = malloc(chunk);
+    int status = -1;
+
+    if (buffer == NULL) {
+        fprintf(stderr, "xtsStream: out of memory\n");
+        return -1;
+    }
+
+    for (;;) {
+        ssize_t got = readFull(in, buffer, chunk);
+        if (got < 0) {
+            perror("read");
+            goto done;
+        }
+
+        int error = mode == ENCRYPT
+            ? prince_xts_encrypt_sectors(xts, sector, sectorBytes, buffer, buffer, got, threads)
+            : prince_xts_decrypt_sectors(xts, sector, sectorBytes, buffer, buffer, got, threads);
+        if (error != 0) {
+            goto done;
+        }
+
+        if (writeFull(out, buffer, got) != 0) {
+            perror("write");
+            goto done;
+        }
+
+        if ((size_t) got < chunk) {
+            break;
+        }
+        sector += chunk / sectorBytes;
+    }
+
+    status = 0;
+
+done:
+    free(buffer);
+    return status;
+}
+
+/* princev2cipher --xts {E/D} k0 k1 t0 t1 in out [--sector bytes] [--first n] [--threads T] */
+static int xtsMode(int argc, char* argv[]) {
+    uint64_t k0, k1, t0, t1, first = 0, sectorBytes = 512, threads = 0;
+    int valid = argc >= 9 && parseMode(argv[2]) >= 0;
+
+    for (int i = 9; valid && i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            valid = 0;
+        } else if (!strcmp(argv[i], "--sector")) {
+            valid = parseDecimal("sector", argv[i + 1], &sectorBytes) == 0;
+        } else if (!strcmp(argv[i], "--first")) {
+            valid = parseDecimal("first", argv[i + 1], &first) == 0;
+        } else if (!strcmp(argv[i], "--threads")) {
+            valid = parseDecimal("threads", argv[i + 1], &threads) == 0;
+        } else {
+            valid = 0;
+        }
+    }
+
+    if (!valid) {
+        fprintf(stderr, "Usage: %s --xts {E/D} k0 k1 t0 t1 in out [--sector bytes] "
+                "[--first n] [--threads T]\n", argv[0]);
+        return -1;
+    }
+
+    if (parseHex("k0", argv[3], &k0) != 0 || parseHex("k1", argv[4], &k1) != 0 ||
+        parseHex("t0", argv[5], &t0) != 0 || parseHex("t1", argv[6], &t1) != 0) {
+        return -1;
+    }
+
+    if (sectorBytes < XTS_MIN_SECTOR_BYTES || sectorBytes > FILE_CHUNK_BLOCKS * BLOCK_BYTES ||
+        threads > XTS_MAX_THREADS) {
+        fprintf(stderr, "%s: sectors have to be %d to %d bytes, at most %d threads\n",
+                argv[0], XTS_MIN_SECTOR_BYTES, FILE_CHUNK_BLOCKS * BLOCK_BYTES, XTS_MAX_THREADS);
+        return -1;
+    }
+
+    int in = strcmp(argv[7], "-") ? open(argv[7], O_RDONLY) : STDIN_FILENO;
+    if (in < 0) {
+        perror(argv[7]);
+        return -1;
+    }
+
+    int out = strcmp(argv[8], "-") ? open(argv[8], O_WRONLY | O_CREAT | O_TRUNC, 0644)
+                                   : STDOUT_FILENO;
+    if (out < 0) {
+        perror(argv[8]);
+        close(in);
+        return -1;
+    }
+
+    princev2xts_t xts;
+    prince_xts_init(&xts, key_new(k0, k1), key_new(t0, t1));
+    int status = xtsStream(parseMode(argv[2]), &xts, first, sectorBytes, threads, in, out);
+
+    close(in);
+    if (close(out) != 0 && status == 0) {
+        perror(argv[8]);
+        status = -1;
+    }
+
+    return status;
+}
+
+/* parses up to 16 hex digits at *pos followed by blank space, moves *pos
+   past them. returns 0 if no error */
+static int parseToken(const char** pos, const char* end, uint64_t* value) {
+    const char* p = *pos;
+
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+
+    const char* token = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+        p++;
+    }
+
+    if (hex_parse(token, p - token, value) != 0) {
+        return -1;
+    }
+
+    *pos = p;
+    return 0;
+}
+
+typedef struct batch {
+    int mode;
+    int fixedKey;
+    princev2key_t keys[BATCH_BLOCKS];
+    uint64_t blocks[BATCH_BLOCKS];
+    size_t n;
+    char text[BATCH_BLOCKS * (HEX_DIGITS + 1)];
+} batch_t;
+
+/* runs blocks first..last - 1 with a key per block */
+static void batchKeys(batch_t* batch, size_t first, size_t last) {
+    if (batch->mode == ENCRYPT) {
+        prince_encrypt_keys_blocks(batch->keys + first, batch->blocks + first,
+                                   batch->blocks + first, last - first);
+    } else {
+        prince_decrypt_keys_blocks(batch->keys + first, batch->blocks + first,
+                                   batch->blocks + first, last - first);
+    }
+}
+
+/* runs the collected blocks, long runs of lines under one key with that
+   key expanded once, everything in between with one key per block */
+static void batchFlush(batch_t* batch, FILE* out) {
+    size_t i = 0, mixed = 0;
+
+    while (i < batch->n) {
+        princev2key_t key = batch->keys[i];
+        size_t run = 1;
+
+        while (i + run < batch->n && batch->keys[i + run].k0 == key.k0 &&
+               batch->keys[i + run].k1 == key.k1) {
+            run++;
+        }
+
+        if (batch->fixedKey || run >= BATCH_MIN_RUN) {
+            batchKeys(batch, mixed, i);
+            if (batch->mode == ENCRYPT) {
+                prince_encrypt_blocks(key, batch->blocks + i, batch->blocks + i, run);
+            } else {
+                prince_decrypt_blocks(key, batch->blocks + i, batch->blocks + i, run);
+            }
+            mixed = i + run;
+        }
+
+        i += run;
+    }
+    batchKeys(batch, mixed, batch->n);
+
+    fwrite(batch->text, 1, hex_encodeLines(batch->blocks, batch->n, batch->text), out);
+    batch->n = 0;
+}
+
+/* princev2cipher --batch {E/D} [k0 k1] */
+static int batchMode(int argc, char* argv[]) {
+    if ((argc != 3 && argc != 5) || parseMode(argv[2]) < 0) {
+        fprintf(stderr, "Usage: %s --batch {E/D} [k0 k1] < lines\n", argv[0]);
+        return -1;
+    }
+
+    batch_t* batch = malloc(sizeof(batch_t));
+    char* input = malloc(BATCH_READ_BYTES + BATCH_MAX_LINE);
+    int status = -1;
+
+    if (batch == NULL || input == NULL) {
+        fprintf(stderr, "batchMode: out of memory\n");
+        goto done;
+    }
+
+    batch->mode = parseMode(argv[2]);
+    batch->fixedKey = argc == 5;
+    batch->n = 0;
+
+    princev2key_t key = key_new(0, 0);
+    if (batch->fixedKey) {
+        uint64_t k0, k1;
+        if (parseHex("k0", argv[3], &k0) != 0 || parseHex("k1", argv[4], &k1) != 0) {
+            goto done;
+        }
+        key = key_new(k0, k1);
+    }
+
+    size_t lineNumber = 0;
+    size_t kept = 0; /* bytes of an unfinished line from the previous read */
+
+    for (;;) {
+        size_t got = fread(input + kept, 1, BATCH_READ_BYTES, stdin);
+        const char* end = input + kept + got;
+        const char* line = input;
+        int eof = got == 0;
+
+        if (eof && kept == 0) {
+            break;
+        }
+
+        while (line < end) {
+            const char* newline = memchr(line, '\n', end - line);
+            if (newline == NULL) {
+                if (!eof) {
+                    break;
+                }
+                newline = end; /* last line without newline */
+            }
+
+            lineNumber++;
+
+            const char* pos = line;
+            line = newline + 1;
+
+            while (pos < newline && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+                pos++;
+            }
+            if (pos == newline) {
+                continue; /* blank line */
+            }
+
+            uint64_t k0 = key.k0, k1 = key.k1, m;
+            int error = (!batch->fixedKey && (parseToken(&pos, newline, &k0) != 0 ||
+                                              parseToken(&pos, newline, &k1) != 0)) ||
+                        parseToken(&pos, newline, &m) != 0;
+
+            while (!error && pos < newline && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+                pos++;
+            }
+            if (error || pos != newline) {
+                fprintf(stderr, "%s: line %zu: expected %s\n", argv[0], lineNumber,
+                        batch->fixedKey ? "m" : "k0 k1 m");
+                goto done;
+            }
+
+            batch->keys[batch->n] = key_new(k0, k1);
+            batch->blocks[batch->n] = m;
+            if (++batch->n == BATCH_BLOCKS) {
+                batchFlush(batch, stdout);
+            }
+        }
+
+        if (eof) {
+            break;
+        }
+
+        kept = line < end ? end - line : 0;
+        if (kept > BATCH_MAX_LINE) {
+            fprintf(stderr, "%s: line %zu too long\n", argv[0], lineNumber + 1);
+            goto done;
+        }
+        memmove(input, line, kept);
+    }
+
+    if (ferror(stdin)) {
+        perror("stdin");
+        goto done;
+    }
+
+    batchFlush(batch, stdout);
+    status = fflush(stdout) == 0 ? 0 : -1;
+
+done:
+    free(batch);
+    free(input);
+    return status;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "--file")) {
+        return fileMode(argc, argv);
+    }
+    if (argc > 1 && !strcmp(argv[1], "--batch")) {
+        return batchMode(argc, argv);
+    }
+    if (argc > 1 && !strcmp(argv[1], "--xts")) {
+        return xtsMode(argc, argv);
+    }
+
     // check number of arguments
     if (argc != 5) {
         fprintf(stderr,
-                "Usage: %s {E/D} k0 k1 m\t# encrypt/decrypt with 128-bit key\n",
-                argv[0]);
+                "Usage: %s {E/D} k0 k1 m\t# encrypt/decrypt with 128-bit key\n"
+                "       %s --batch {E/D} [k0 k1]\t# one block per line from stdin\n"
+                "       %s --file {E/D} k0 k1 in out\t# encrypt/decrypt a file\n"
+                "       %s --xts {E/D} k0 k1 t0 t1 in out [--sector bytes] [--first n] "
+                "[--threads T]\t# encrypt/decrypt sectors\n",
+                argv[0], argv[0], argv[0], argv[0]);
         return -1;
     }
 
     // parse encryption/decryption flag
-    int mode;
-    if (!strcmp(argv[1], "E")) {
-        mode = ENCRYPT;
-    } else if (!strcmp(argv[1], "D")) {
-        mode = DECRYPT;
-    } else {
+    int mode = parseMode(argv[1]);
+    if (mode < 0) {
         fprintf(stderr,
                 "%s: incorrect usage\n(to encrypt) %s E k0 k1 m\n(to decrypt) %s D k0 k1 c\n",
                 argv[0], argv[0], argv[0]);
@@ -50,25 +609,13 @@ int main(int argc, char* argv[]) {
     uint64_t k0 = 0;
     uint64_t k1 = 0;
 
-    char *checkptr;
-    if (argc == 5) {
-        k0 = strtoul(argv[2], &checkptr, 16);
-        if (*checkptr != '\0') {
-            fprintf(stderr, "failed to parse k0 = %s from %s on\n", argv[2], checkptr);
-            return -1;
-        }
-
-        k1 = strtoul(argv[3], &checkptr, 16);
-        if (*checkptr != '\0') {
-            fprintf(stderr, "failed to parse k1 = %s from %s on\n", argv[3], checkptr);
-            return -1;
-        }
+    if (parseHex("k0", argv[2], &k0) != 0 || parseHex("k1", argv[3], &k1) != 0) {
+        return -1;
     }
 
     // parse input block
-    uint64_t m = strtoul(argv[argc-1], &checkptr, 16);
-    if (*checkptr != '\0') {
-        fprintf(stderr, "failed to parse m = %s from %s on\n", argv[argc-1], checkptr);
+    uint64_t m;
+    if (parseHex("m", argv[argc-1], &m) != 0) {
         return -1;
     }
 
@@ -0,0 +1,180 @@
+/**
+princev2ctr.c
+
+Multi-threaded counter mode on top of PRINCEv2
+
+The buffer is cut into one contiguous range of blocks per thread. A worker
+derives the counters of its range from the start counter and its offset,
+so workers share nothing but the read-only key, and the output does not
+depend on the number of threads. Every range is processed in tiles that
+fit into the L1 cache, each tile going through prince_encrypt_blocks.
+**/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "princev2ctr.h"
+#include "princev2.h"
+#include "misc.h"
+
+/* blocks per tile, a multiple of every engine's batch size */
+enum {CTR_TILE_BLOCKS = 1024};
+
+/* ranges smaller than this are not worth a thread */
+enum {CTR_MIN_BLOCKS_PER_THREAD = 16 * CTR_TILE_BLOCKS};
+
+enum {CTR_MAX_THREADS = 256};
+
+enum {BLOCK_BYTES = sizeof(uint64_t)};
+
+typedef struct ctrjob {
+    princev2key_t key;
+    uint64_t counter;     /* counter of the first block of the range */
+    const uint8_t* in;    /* NULL for the plain keystream */
+    uint8_t* out;
+    uint64_t* blocks;     /* plain keystream output */
+    size_t len;           /* bytes, or blocks for the plain keystream */
+} ctrjob_t;
+
+int prince_ctr_threads() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpus < 1) {
+        return 1;
+    }
+
+    return cpus < CTR_MAX_THREADS ? (int) cpus : CTR_MAX_THREADS;
+}
+
+static void prince_ctr_fill(princev2key_t key, uint64_t counter, uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = counter + i;
+    }
+
+    prince_encrypt_blocks(key, out, out, n);
+}
+
+static void prince_ctr_run(const ctrjob_t* job) {
+    if (job->in == NULL) {
+        for (size_t i = 0; i < job->len; i += CTR_TILE_BLOCKS) {
+            size_t blocks = job->len - i < CTR_TILE_BLOCKS ? job->len - i : CTR_TILE_BLOCKS;
+            prince_ctr_fill(job->key, job->counter + i, job->blocks + i, blocks);
+        }
+        return;
+    }
+
+    uint64_t tile[CTR_TILE_BLOCKS];
+    uint64_t counter = job->counter;
+    const uint8_t* in = job->in;
+    uint8_t* out = job->out;
+    size_t len = job->len;
+
+    while (len > 0) {
+        size_t bytes = len < sizeof(tile) ? len : sizeof(tile);
+        size_t blocks = (bytes + BLOCK_BYTES - 1) / BLOCK_BYTES;
+
+        prince_ctr_fill(job->key, counter, tile, blocks);
+
+        size_t full = bytes / BLOCK_BYTES;
+        for (size_t i = 0; i < full; i++) {
+            uint64_t word = loadBigEndian(in + i * BLOCK_BYTES);
+            storeBigEndian(out + i * BLOCK_BYTES, word ^ tile[i]);
+        }
+
+        /* partial last block, keystream bytes are used most significant first */
+        for (size_t b = full * BLOCK_BYTES; b < bytes; b++) {
+            out[b] = in[b] ^ (uint8_t) (tile[full] >> (8 * (BLOCK_BYTES - 1 - b % BLOCK_BYTES)));
+        }
+
+        counter += blocks;
+        in += bytes;
+        out += bytes;
+        len -= bytes;
+    }
+}
+
+static void* prince_ctr_worker(void* arg) {
+    prince_ctr_run((const ctrjob_t*) arg);
+    return NULL;
+}
+
+/* splits n blocks into ranges of whole tiles and runs one per thread */
+static void prince_ctr_parallel(const ctrjob_t* job, size_t n, int threads) {
+    ctrjob_t jobs[CTR_MAX_THREADS];
+    pthread_t tids[CTR_MAX_THREADS];
+    int started[CTR_MAX_THREADS];
+
+    if (threads <= 0) {
+        threads = prince_ctr_threads();
+    }
+    if (threads > CTR_MAX_THREADS) {
+        threads = CTR_MAX_THREADS;
+    }
+    if ((size_t) threads > n / CTR_MIN_BLOCKS_PER_THREAD) {
+        threads = n / CTR_MIN_BLOCKS_PER_THREAD;
+    }
+    if (threads <= 1) {
+        prince_ctr_run(job);
+        return;
+    }
+
+    size_t tiles = (n + CTR_TILE_BLOCKS - 1) / CTR_TILE_BLOCKS;
+    size_t unit = job->in == NULL ? 1 : BLOCK_BYTES;
+    size_t start = 0;
+
+    for (int t = 0; t < threads; t++) {
+        size_t end = (tiles * (t + 1) / threads) * CTR_TILE_BLOCKS;
+        if (end > n) {
+            end = n;
+        }
+
+        jobs[t] = *job;
+        jobs[t].counter = job->counter + start;
+        if (job->in == NULL) {
+            jobs[t].blocks = job->blocks + start;
+            jobs[t].len = end - start;
+        } else {
+            jobs[t].in = job->in + start * unit;
+            jobs[t].out = job->out + start * unit;
+            jobs[t].len = (t == threads - 1 ? job->len : end * unit) - start * unit;
+        }
+        start = end;
+    }
+
+    /* the calling thread takes the first range itself */
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&tids[t], NULL, prince_ctr_worker, &jobs[t]) == 0;
+    }
+
+    prince_ctr_run(&jobs[0]);
+
+    /* ranges whose thread failed to start are done here */
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            prince_ctr_run(&jobs[t]);
+        }
+    }
+}
+
+void prince_ctr_keystream(princev2key_t key, uint64_t counter, uint64_t* out, size_t n,
+                          int threads) {
+    assert(out != NULL || n == 0);
+
+    ctrjob_t job = {.key = key, .counter = counter, .in = NULL, .out = NULL,
+                    .blocks = out, .len = n};
+    prince_ctr_parallel(&job, n, threads);
+}
+
+void prince_ctr_xor(princev2key_t key, uint64_t counter, const uint8_t* in, uint8_t* out,
+                    size_t len, int threads) {
+    assert((in != NULL && out != NULL) || len == 0);
+
+    ctrjob_t job = {.key = key, .counter = counter, .in = in, .out = out,
+                    .blocks = NULL, .len = len};
+    prince_ctr_parallel(&job, (len + BLOCK_BYTES - 1) / BLOCK_BYTES, threads);
+}
@@ -0,0 +1,32 @@
+/**
+princev2ctr.h
+
+Interface for multi-threaded counter mode on top of PRINCEv2
+
+Block i of the keystream is prince_encrypt(key, counter + i), counters
+wrap around modulo 2^64. As bytes, every keystream block is written most
+significant byte first, the same order block_toString prints it in.
+**/
+
+#ifndef _PRINCE_CTR_
+#define _PRINCE_CTR_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "key.h"
+
+/* number of threads used when 0 threads are asked for */
+int prince_ctr_threads();
+
+/* writes keystream blocks counter, ..., counter + n - 1 to out.
+   threads = 0 uses one thread per online CPU */
+void prince_ctr_keystream(princev2key_t key, uint64_t counter, uint64_t* out, size_t n,
+                          int threads);
+
+/* XORs len bytes from in with the keystream starting at counter into out,
+   the last block may be partial. in and out may be the same buffer */
+void prince_ctr_xor(princev2key_t key, uint64_t counter, const uint8_t* in, uint8_t* out,
+                    size_t len, int threads);
+
+#endif
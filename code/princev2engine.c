@@ -0,0 +1,510 @@
+/**
+princev2engine.c
+
+Runtime selection between the PRINCEv2 implementations
+
+At startup the fastest engine this CPU supports is picked, unless the
+PRINCEV2_ENGINE environment variable names another one. Every candidate
+is checked against prince_core before it is used, prince_core itself is
+the fallback if no other engine passes.
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "princev2engine.h"
+#include "princev2.h"
+#include "princev1.h"
+#include "princev2table.h"
+#include "princev2bitslice.h"
+#include "princev2simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PRINCE_HAVE_X86 1
+#else
+#define PRINCE_HAVE_X86 0
+#endif
+
+typedef void (*princeblocks_t)(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+typedef void (*princectxblocks_t)(const princev2ctx_t* ctx, const uint64_t* in,
+                                  uint64_t* out, size_t n);
+typedef void (*princekeysblocks_t)(const princev2key_t* keys, const uint64_t* in,
+                                   uint64_t* out, size_t n);
+typedef void (*princeroundsblocks_t)(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                     int forward, int middle, int backward,
+                                     const uint64_t* in, uint64_t* out, size_t n);
+
+static void prince_engine_referenceEncrypt(princev2key_t key, const uint64_t* in,
+                                           uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_encrypt(key, in[i]);
+    }
+}
+
+static void prince_engine_referenceDecrypt(princev2key_t key, const uint64_t* in,
+                                           uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_decrypt(key, in[i]);
+    }
+}
+
+static void prince_engine_referenceEncryptCtx(const princev2ctx_t* ctx, const uint64_t* in,
+                                              uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_encrypt_ctx(ctx, in[i]);
+    }
+}
+
+static void prince_engine_referenceDecryptCtx(const princev2ctx_t* ctx, const uint64_t* in,
+                                              uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_decrypt_ctx(ctx, in[i]);
+    }
+}
+
+static void prince_engine_referenceEncryptKeys(const princev2key_t* keys, const uint64_t* in,
+                                               uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_encrypt(keys[i], in[i]);
+    }
+}
+
+static void prince_engine_referenceDecryptKeys(const princev2key_t* keys, const uint64_t* in,
+                                               uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_decrypt(keys[i], in[i]);
+    }
+}
+
+static void prince_engine_referenceRounds(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                          int forward, int middle, int backward,
+                                          const uint64_t* in, uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_core_rounds(rk, in[i], forward, middle, backward);
+    }
+}
+
+/* expanding the key costs about as much as encrypting this many blocks
+   with per-block key arithmetic */
+enum {TABLE_CTX_MIN_BLOCKS = 4};
+
+static void prince_engine_tableEncrypt(princev2key_t key, const uint64_t* in,
+                                       uint64_t* out, size_t n) {
+    if (n >= TABLE_CTX_MIN_BLOCKS) {
+        princev2ctx_t ctx;
+        prince_ctx_init(&ctx, key);
+        prince_encrypt_table_blocks(&ctx, in, out, n);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_encrypt_table(key, in[i]);
+    }
+}
+
+static void prince_engine_tableDecrypt(princev2key_t key, const uint64_t* in,
+                                       uint64_t* out, size_t n) {
+    if (n >= TABLE_CTX_MIN_BLOCKS) {
+        princev2ctx_t ctx;
+        prince_ctx_init(&ctx, key);
+        prince_decrypt_table_blocks(&ctx, in, out, n);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_decrypt_table(key, in[i]);
+    }
+}
+
+/* the table engine has no lanes, every block does its own key arithmetic */
+static void prince_engine_tableEncryptKeys(const princev2key_t* keys, const uint64_t* in,
+                                           uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_encrypt_table(keys[i], in[i]);
+    }
+}
+
+static void prince_engine_tableDecryptKeys(const princev2key_t* keys, const uint64_t* in,
+                                           uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_decrypt_table(keys[i], in[i]);
+    }
+}
+
+static const struct {
+    const char* name;
+    princeblocks_t encrypt;
+    princeblocks_t decrypt;
+    princectxblocks_t encryptCtx;
+    princectxblocks_t decryptCtx;
+    princekeysblocks_t encryptKeys;
+    princekeysblocks_t decryptKeys;
+    princeroundsblocks_t encryptRounds;
+} prince_engines[NUM_OF_ENGINES] = {
+    [PRINCE_ENGINE_AUTO]      = {"auto", NULL, NULL, NULL, NULL, NULL, NULL, NULL},
+    [PRINCE_ENGINE_REFERENCE] = {"reference", prince_engine_referenceEncrypt,
+                                              prince_engine_referenceDecrypt,
+                                              prince_engine_referenceEncryptCtx,
+                                              prince_engine_referenceDecryptCtx,
+                                              prince_engine_referenceEncryptKeys,
+                                              prince_engine_referenceDecryptKeys,
+                                              prince_engine_referenceRounds},
+    [PRINCE_ENGINE_TABLE]     = {"table", prince_engine_tableEncrypt, prince_engine_tableDecrypt,
+                                          prince_encrypt_table_blocks,
+                                          prince_decrypt_table_blocks,
+                                          prince_engine_tableEncryptKeys,
+                                          prince_engine_tableDecryptKeys,
+                                          prince_encrypt_table_rounds},
+    [PRINCE_ENGINE_BITSLICE]  = {"bitslice", prince_encrypt_bitslice, prince_decrypt_bitslice,
+                                             prince_encrypt_bitslice_ctx,
+                                             prince_decrypt_bitslice_ctx,
+                                             prince_encrypt_keys_bitslice,
+                                             prince_decrypt_keys_bitslice,
+                                             prince_encrypt_bitslice_rounds},
+#if PRINCE_HAVE_X86
+    [PRINCE_ENGINE_SSSE3]     = {"ssse3", prince_encrypt_ssse3, prince_decrypt_ssse3,
+                                          prince_encrypt_ssse3_ctx, prince_decrypt_ssse3_ctx,
+                                          prince_encrypt_keys_ssse3, prince_decrypt_keys_ssse3,
+                                          prince_encrypt_rounds_ssse3},
+    [PRINCE_ENGINE_AVX2]      = {"avx2", prince_encrypt_avx2, prince_decrypt_avx2,
+                                         prince_encrypt_avx2_ctx, prince_decrypt_avx2_ctx,
+                                         prince_encrypt_keys_avx2, prince_decrypt_keys_avx2,
+                                         prince_encrypt_rounds_avx2},
+    [PRINCE_ENGINE_AVX512]    = {"avx512", prince_encrypt_avx512, prince_decrypt_avx512,
+                                           prince_encrypt_avx512_ctx, prince_decrypt_avx512_ctx,
+                                           prince_encrypt_keys_avx512,
+                                           prince_decrypt_keys_avx512,
+                                           prince_encrypt_rounds_avx512},
+#else
+    [PRINCE_ENGINE_SSSE3]     = {"ssse3", NULL, NULL, NULL, NULL, NULL, NULL, NULL},
+    [PRINCE_ENGINE_AVX2]      = {"avx2", NULL, NULL, NULL, NULL, NULL, NULL, NULL},
+    [PRINCE_ENGINE_AVX512]    = {"avx512", NULL, NULL, NULL, NULL, NULL, NULL, NULL},
+#endif
+};
+
+/* automatic choice, fastest first */
+static const princeengine_t prince_engine_preference[] = {
+    PRINCE_ENGINE_AVX512,
+    PRINCE_ENGINE_AVX2,
+    PRINCE_ENGINE_SSSE3,
+    PRINCE_ENGINE_BITSLICE,
+    PRINCE_ENGINE_TABLE,
+};
+
+/* a bitsliced call always costs as much as 64 blocks, fewer blocks than
+   this go through the table engine instead */
+enum {BITSLICE_MIN_BLOCKS = 8};
+
+static princeengine_t prince_engine_auto = PRINCE_ENGINE_REFERENCE;
+static princeengine_t prince_engine_selected = PRINCE_ENGINE_REFERENCE;
+
+const char* prince_engine_name(princeengine_t engine) {
+    if (engine < 0 || engine >= NUM_OF_ENGINES) {
+        return "unknown";
+    }
+
+    return prince_engines[engine].name;
+}
+
+int prince_engine_fromName(const char* name, princeengine_t* engine) {
+    for (int e = 0; e < NUM_OF_ENGINES; e++) {
+        if (!strcmp(name, prince_engines[e].name)) {
+            *engine = e;
+            return 0;
+        }
+    }
+
+    return -1; /* error */
+}
+
+int prince_engine_supported(princeengine_t engine) {
+    switch (engine) {
+    case PRINCE_ENGINE_AUTO:
+    case PRINCE_ENGINE_REFERENCE:
+    case PRINCE_ENGINE_TABLE:
+    case PRINCE_ENGINE_BITSLICE:
+        return 1;
+#if PRINCE_HAVE_X86
+    case PRINCE_ENGINE_SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case PRINCE_ENGINE_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case PRINCE_ENGINE_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int prince_engine_selfTest(princeengine_t engine) {
+    enum {NUM_OF_TESTS = 67}; /* more than one bitsliced batch */
+    uint64_t p[NUM_OF_TESTS], c[NUM_OF_TESTS], d[NUM_OF_TESTS];
+    princev2key_t keys[NUM_OF_TESTS];
+
+    if (engine == PRINCE_ENGINE_AUTO || !prince_engine_supported(engine)) {
+        return -1; /* error */
+    }
+
+    princev2key_t key = key_new(0x0123456789abcdef, 0xfedcba9876543210);
+
+    for (int i = 0; i < NUM_OF_TESTS; i++) {
+        p[i] = 0x9e3779b97f4a7c15 * (i + 1);
+    }
+
+    prince_engines[engine].encrypt(key, p, c, NUM_OF_TESTS);
+    prince_engines[engine].decrypt(key, c, d, NUM_OF_TESTS);
+
+    for (int i = 0; i < NUM_OF_TESTS; i++) {
+        if (c[i] != prince_encrypt(key, p[i]) || d[i] != p[i]) {
+            return -1; /* error */
+        }
+    }
+
+    /* a different key in every lane */
+    for (int i = 0; i < NUM_OF_TESTS; i++) {
+        keys[i] = key_new(key.k0 * (i + 1), key.k1 ^ p[i]);
+    }
+
+    prince_engines[engine].encryptKeys(keys, p, c, NUM_OF_TESTS);
+    prince_engines[engine].decryptKeys(keys, c, d, NUM_OF_TESTS);
+
+    for (int i = 0; i < NUM_OF_TESTS; i++) {
+        if (c[i] != prince_encrypt(keys[i], p[i]) || d[i] != p[i]) {
+            return -1; /* error */
+        }
+    }
+
+    /* a key expanded once, for PRINCEv2 and for PRINCE */
+    princev2ctx_t ctx;
+
+    prince_ctx_init(&ctx, key);
+    prince_engines[engine].encryptCtx(&ctx, p, c, NUM_OF_TESTS);
+    prince_engines[engine].decryptCtx(&ctx, c, d, NUM_OF_TESTS);
+
+    for (int i = 0; i < NUM_OF_TESTS; i++) {
+        if (c[i] != prince_encrypt(key, p[i]) || d[i] != p[i]) {
+            return -1; /* error */
+        }
+    }
+
+    prince_v1_ctx_init(&ctx, key);
+    prince_engines[engine].encryptCtx(&ctx, p, c, NUM_OF_TESTS);
+    prince_engines[engine].decryptCtx(&ctx, c, d, NUM_OF_TESTS);
+
+    for (int i = 0; i < NUM_OF_TESTS; i++) {
+        if (c[i] != prince_v1_encrypt(key, p[i]) || d[i] != p[i]) {
+            return -1; /* error */
+        }
+    }
+
+    /* a reduced-round core without the middle layer */
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+    uint64_t reversed[NUM_OF_KEY_ADDITIONS];
+
+    prince_roundKeys(key, ENC, rk);
+    for (int k = 0; k < NUM_OF_KEY_ADDITIONS; k++) {
+        reversed[k] = rk[NUM_OF_KEY_ADDITIONS - 1 - k];
+    }
+
+    prince_engines[engine].encryptRounds(rk, 2, 0, 3, p, c, NUM_OF_TESTS);
+    prince_engines[engine].encryptRounds(reversed, 3, 0, 2, c, d, NUM_OF_TESTS);
+
+    for (int i = 0; i < NUM_OF_TESTS; i++) {
+        if (c[i] != prince_core_rounds(rk, p[i], 2, 0, 3) || d[i] != p[i]) {
+            return -1; /* error */
+        }
+    }
+
+    return 0;
+}
+
+princeengine_t prince_engine_get() {
+    return prince_engine_selected;
+}
+
+int prince_engine_set(princeengine_t engine) {
+    if (engine == PRINCE_ENGINE_AUTO) {
+        prince_engine_selected = prince_engine_auto;
+        return 0;
+    }
+
+    if (engine < 0 || engine >= NUM_OF_ENGINES || !prince_engine_supported(engine)) {
+        fprintf(stderr, "prince_engine_set: engine %s not supported on this CPU\n",
+                prince_engine_name(engine));
+        return -1; /* error */
+    }
+
+    prince_engine_selected = engine;
+    return 0;
+}
+
+/* picks the engine before main, so the hot path never checks. Runs after
+   the table initializers of the engines (priority 101) */
+__attribute__((constructor(102)))
+static void prince_engine_init(void) {
+#if PRINCE_HAVE_X86
+    __builtin_cpu_init();
+#endif
+
+    for (size_t i = 0; i < sizeof(prince_engine_preference) / sizeof(princeengine_t); i++) {
+        princeengine_t engine = prince_engine_preference[i];
+
+        if (prince_engine_supported(engine) && prince_engine_selfTest(engine) == 0) {
+            prince_engine_auto = engine;
+            break;
+        }
+    }
+    prince_engine_selected = prince_engine_auto;
+
+    const char* name = getenv(PRINCE_ENGINE_ENV);
+    if (name != NULL && *name != '\0') {
+        princeengine_t engine;
+
+        if (prince_engine_fromName(name, &engine) != 0) {
+            fprintf(stderr, "prince_engine_init: unknown engine %s=%s, using %s\n",
+                    PRINCE_ENGINE_ENV, name, prince_engine_name(prince_engine_auto));
+        } else {
+            prince_engine_set(engine);
+        }
+    }
+}
+
+static princeengine_t prince_engine_resolve(princeengine_t engine, size_t n) {
+    if (engine == PRINCE_ENGINE_AUTO) {
+        engine = prince_engine_selected;
+
+        if (engine == PRINCE_ENGINE_BITSLICE && n < BITSLICE_MIN_BLOCKS) {
+            engine = PRINCE_ENGINE_TABLE;
+        }
+    }
+
+    return engine;
+}
+
+void prince_engine_encrypt(princeengine_t engine, princev2key_t key,
+                           const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engines[prince_engine_resolve(engine, n)].encrypt(key, in, out, n);
+}
+
+void prince_engine_decrypt(princeengine_t engine, princev2key_t key,
+                           const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engines[prince_engine_resolve(engine, n)].decrypt(key, in, out, n);
+}
+
+void prince_engine_encrypt_ctx(princeengine_t engine, const princev2ctx_t* ctx,
+                               const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engines[prince_engine_resolve(engine, n)].encryptCtx(ctx, in, out, n);
+}
+
+void prince_engine_decrypt_ctx(princeengine_t engine, const princev2ctx_t* ctx,
+                               const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engines[prince_engine_resolve(engine, n)].decryptCtx(ctx, in, out, n);
+}
+
+void prince_engine_encrypt_keys(princeengine_t engine, const princev2key_t* keys,
+                                const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engines[prince_engine_resolve(engine, n)].encryptKeys(keys, in, out, n);
+}
+
+void prince_engine_decrypt_keys(princeengine_t engine, const princev2key_t* keys,
+                                const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engines[prince_engine_resolve(engine, n)].decryptKeys(keys, in, out, n);
+}
+
+int prince_engine_encrypt_rounds(princeengine_t engine, const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n) {
+    if (forward < 0 || forward > NUM_OF_FORWARD_ROUNDS ||
+        backward < 0 || backward > NUM_OF_INVERSE_ROUNDS) {
+        fprintf(stderr, "prince_engine_encrypt_rounds: invalid rounds %d/%d/%d\n",
+                forward, middle, backward);
+        return -1; /* error */
+    }
+
+    prince_engines[prince_engine_resolve(engine, n)].encryptRounds(rk, forward, middle,
+                                                                   backward, in, out, n);
+    return 0;
+}
+
+/* undoing forward round i is an inverse round adding rk[i] and the other
+   way around, and the middle layer inverts with its two keys swapped, so
+   the inverse is the same structure with the key list reversed */
+int prince_engine_decrypt_rounds(princeengine_t engine, const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t reversed[NUM_OF_KEY_ADDITIONS];
+
+    for (int k = 0; k < NUM_OF_KEY_ADDITIONS; k++) {
+        reversed[k] = rk[NUM_OF_KEY_ADDITIONS - 1 - k];
+    }
+
+    return prince_engine_encrypt_rounds(engine, reversed, backward, middle, forward, in, out, n);
+}
+
+/* unaligned buffers go through an aligned buffer of this many blocks */
+enum {BOUNCE_BLOCKS = 256};
+
+static void prince_engine_blocks(princemode_t mode, princev2key_t key,
+                                 const uint64_t* in, uint64_t* out, size_t n) {
+    if ((((uintptr_t) in | (uintptr_t) out) & (sizeof(uint64_t) - 1)) == 0) {
+        if (mode == ENC) {
+            prince_engine_encrypt(PRINCE_ENGINE_AUTO, key, in, out, n);
+        } else {
+            prince_engine_decrypt(PRINCE_ENGINE_AUTO, key, in, out, n);
+        }
+        return;
+    }
+
+    uint64_t buffer[BOUNCE_BLOCKS];
+
+    while (n > 0) {
+        size_t count = n < BOUNCE_BLOCKS ? n : BOUNCE_BLOCKS;
+
+        memcpy(buffer, in, count * sizeof(uint64_t));
+        if (mode == ENC) {
+            prince_engine_encrypt(PRINCE_ENGINE_AUTO, key, buffer, buffer, count);
+        } else {
+            prince_engine_decrypt(PRINCE_ENGINE_AUTO, key, buffer, buffer, count);
+        }
+        memcpy(out, buffer, count * sizeof(uint64_t));
+
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
+
+void prince_encrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engine_blocks(ENC, key, in, out, n);
+}
+
+void prince_decrypt_blocks(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    prince_engine_blocks(DEC, key, in, out, n);
+}
+
+void prince_encrypt_keys_blocks(const princev2key_t* keys, const uint64_t* in,
+                                uint64_t* out, size_t n) {
+    prince_engine_encrypt_keys(PRINCE_ENGINE_AUTO, keys, in, out, n);
+}
+
+void prince_decrypt_keys_blocks(const princev2key_t* keys, const uint64_t* in,
+                                uint64_t* out, size_t n) {
+    prince_engine_decrypt_keys(PRINCE_ENGINE_AUTO, keys, in, out, n);
+}
+
+int prince_encrypt_rounds_blocks(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n) {
+    return prince_engine_encrypt_rounds(PRINCE_ENGINE_AUTO, rk, forward, middle, backward,
+                                        in, out, n);
+}
+
+int prince_decrypt_rounds_blocks(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n) {
+    return prince_engine_decrypt_rounds(PRINCE_ENGINE_AUTO, rk, forward, middle, backward,
+                                        in, out, n);
+}
@@ -0,0 +1,78 @@
+/**
+princev2engine.h
+
+Interface for selecting between the PRINCEv2 implementations at runtime
+**/
+
+#ifndef _PRINCE_ENGINE_
+#define _PRINCE_ENGINE_
+
+#include <stddef.h>
+
+#include "key.h"
+#include "princev2.h"
+
+typedef enum {
+    PRINCE_ENGINE_AUTO = 0, /* whatever prince_engine_get returns */
+    PRINCE_ENGINE_REFERENCE,
+    PRINCE_ENGINE_TABLE,
+    PRINCE_ENGINE_BITSLICE,
+    PRINCE_ENGINE_SSSE3,
+    PRINCE_ENGINE_AVX2,
+    PRINCE_ENGINE_AVX512,
+    NUM_OF_ENGINES
+} princeengine_t;
+
+/* environment variable that overrides the automatic choice at startup */
+#define PRINCE_ENGINE_ENV "PRINCEV2_ENGINE"
+
+/* returns the name of engine, as accepted in PRINCEV2_ENGINE */
+const char* prince_engine_name(princeengine_t engine);
+
+/* sets engine to the engine called name. Returns 0 if no error */
+int prince_engine_fromName(const char* name, princeengine_t* engine);
+
+/* returns nonzero if this CPU can run engine */
+int prince_engine_supported(princeengine_t engine);
+
+/* returns 0 if engine agrees with the reference code on a set of test
+   vectors, with a key, a key per block, keys expanded by prince_ctx_init
+   and prince_v1_ctx_init and a reduced-round core */
+int prince_engine_selfTest(princeengine_t engine);
+
+/* returns the engine used for PRINCE_ENGINE_AUTO */
+princeengine_t prince_engine_get();
+
+/* forces the engine used for PRINCE_ENGINE_AUTO, PRINCE_ENGINE_AUTO restores
+   the automatic choice. Returns 0 if no error */
+int prince_engine_set(princeengine_t engine);
+
+/* encrypts/decrypts n blocks from in to out with the given engine.
+   in and out may be the same array */
+void prince_engine_encrypt(princeengine_t engine, princev2key_t key,
+                           const uint64_t* in, uint64_t* out, size_t n);
+void prince_engine_decrypt(princeengine_t engine, princev2key_t key,
+                           const uint64_t* in, uint64_t* out, size_t n);
+
+/* same with a key expanded by prince_ctx_init (or prince_v1_ctx_init) */
+void prince_engine_encrypt_ctx(princeengine_t engine, const princev2ctx_t* ctx,
+                               const uint64_t* in, uint64_t* out, size_t n);
+void prince_engine_decrypt_ctx(princeengine_t engine, const princev2ctx_t* ctx,
+                               const uint64_t* in, uint64_t* out, size_t n);
+
+/* same with a key of its own for every block, in[i] goes through keys[i] */
+void prince_engine_encrypt_keys(princeengine_t engine, const princev2key_t* keys,
+                                const uint64_t* in, uint64_t* out, size_t n);
+void prince_engine_decrypt_keys(princeengine_t engine, const princev2key_t* keys,
+                                const uint64_t* in, uint64_t* out, size_t n);
+
+/* prince_core_rounds on n blocks under the key list rk with the given
+   engine, and its inverse. Returns 0 if no error */
+int prince_engine_encrypt_rounds(princeengine_t engine, const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n);
+int prince_engine_decrypt_rounds(princeengine_t engine, const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n);
+
+#endif
@@ -0,0 +1,131 @@
+/**
+princev2fast.h
+
+Latency-optimized PRINCEv2 for one block at a time, header only
+
+prince_encrypt_fast and prince_decrypt_fast compute the same as
+prince_encrypt and prince_decrypt, but are meant to be inlined into the
+caller: all twelve rounds are written out, the round constants, ALPHA and
+BETA are literals that the compiler folds into one immediate per key
+addition, and nothing is read from memory. The S-box is its algebraic
+normal form evaluated on the four bit planes of all 16 nibbles at once
+(bit t of every nibble is (state >> t) & PRINCE_FAST_NIBBLE_LSB), so there
+is no table lookup whose timing or cache misses depend on the data.
+
+M' and SR are the word level layers of princev2layers.h, which
+princev2.c uses as well.
+
+Sample Usage:
+
+#include "princev2fast.h"
+
+uint64_t c = prince_encrypt_fast(key, p);
+**/
+
+#ifndef _PRINCE_FAST_
+#define _PRINCE_FAST_
+
+#include "key.h"
+#include "princev2layers.h"
+
+/* copies of ALPHA, BETA and RCs of key.c as constant expressions */
+#define PRINCE_FAST_ALPHA 0xc0ac29b7c97c50dd
+#define PRINCE_FAST_BETA  0x3f84d5b5b5470917
+#define PRINCE_FAST_RC1   0x13198a2e03707344
+#define PRINCE_FAST_RC2   0xa4093822299f31d0
+#define PRINCE_FAST_RC3   0x082efa98ec4e6c89
+#define PRINCE_FAST_RC4   0x452821e638d01377
+#define PRINCE_FAST_RC5   0xbe5466cf34e90c6c
+#define PRINCE_FAST_RC6   (PRINCE_FAST_RC5 ^ PRINCE_FAST_ALPHA)
+#define PRINCE_FAST_RC7   (PRINCE_FAST_RC4 ^ PRINCE_FAST_BETA)
+#define PRINCE_FAST_RC8   (PRINCE_FAST_RC3 ^ PRINCE_FAST_ALPHA)
+#define PRINCE_FAST_RC9   (PRINCE_FAST_RC2 ^ PRINCE_FAST_BETA)
+#define PRINCE_FAST_RC10  (PRINCE_FAST_RC1 ^ PRINCE_FAST_ALPHA)
+
+/* the least significant bit of every nibble */
+#define PRINCE_FAST_NIBBLE_LSB 0x1111111111111111
+
+/* prince_sbox on all nibbles, same circuit as princev2bitslice.c with the
+   complements as XOR by PRINCE_FAST_NIBBLE_LSB */
+static inline uint64_t prince_fast_s_layer(uint64_t state) {
+    const uint64_t l = PRINCE_FAST_NIBBLE_LSB;
+    uint64_t x0 = state & l, x1 = (state >> 1) & l;
+    uint64_t x2 = (state >> 2) & l, x3 = (state >> 3) & l;
+
+    uint64_t x01 = x0 & x1, x02 = x0 & x2, x03 = x0 & x3;
+    uint64_t x12 = x1 & x2, x13 = x1 & x3, x23 = x2 & x3;
+    uint64_t x012 = x01 & x2, x013 = x01 & x3, x023 = x02 & x3, x123 = x12 & x3;
+
+    uint64_t y0 = l ^ x01 ^ x2 ^ x12 ^ x012 ^ x3 ^ x03 ^ x23;
+    uint64_t y1 = l ^ x02 ^ x12 ^ x012 ^ x13 ^ x123;
+    uint64_t y2 = x0 ^ x01 ^ x3 ^ x03 ^ x13 ^ x013 ^ x123;
+    uint64_t y3 = l ^ x1 ^ x12 ^ x012 ^ x3 ^ x013 ^ x23 ^ x023;
+
+    return y0 | (y1 << 1) | (y2 << 2) | (y3 << 3);
+}
+
+/* prince_sbox_inverse on all nibbles */
+static inline uint64_t prince_fast_s_layer_inverse(uint64_t state) {
+    const uint64_t l = PRINCE_FAST_NIBBLE_LSB;
+    uint64_t x0 = state & l, x1 = (state >> 1) & l;
+    uint64_t x2 = (state >> 2) & l, x3 = (state >> 3) & l;
+
+    uint64_t x01 = x0 & x1, x02 = x0 & x2;
+    uint64_t x12 = x1 & x2, x13 = x1 & x3, x23 = x2 & x3;
+    uint64_t x012 = x01 & x2, x013 = x01 & x3, x023 = x02 & x3, x123 = x12 & x3;
+
+    uint64_t y0 = l ^ x01 ^ x12 ^ x3 ^ x013 ^ x23 ^ x023;
+    uint64_t y1 = l ^ x02 ^ x12 ^ x012 ^ x13 ^ x23;
+    uint64_t y2 = x0 ^ x01 ^ x2 ^ x02 ^ x12 ^ x012 ^ x13 ^ x013;
+    uint64_t y3 = l ^ x0 ^ x1 ^ x01 ^ x02 ^ x12 ^ x012 ^ x23 ^ x023 ^ x123;
+
+    return y0 | (y1 << 1) | (y2 << 2) | (y3 << 3);
+}
+
+static inline uint64_t prince_fast_roundForward(uint64_t state, uint64_t rk) {
+    return prince_word_shiftRow(prince_word_m_layer(prince_fast_s_layer(state))) ^ rk;
+}
+
+static inline uint64_t prince_fast_roundInverse(uint64_t state, uint64_t rk) {
+    state = prince_word_m_layer(prince_word_shiftRowInverse(state ^ rk));
+    return prince_fast_s_layer_inverse(state);
+}
+
+/* prince_core unrolled: a0/a1 are the key words of the whitening, forward
+   rounds and the first middle addition, b0/b1 those of the rest (they
+   differ by ALPHA ^ BETA for decryption) */
+static inline __attribute__((always_inline))
+uint64_t prince_fast_core(uint64_t a0, uint64_t a1, uint64_t b0, uint64_t b1, uint64_t state) {
+    state ^= a0;
+    state = prince_fast_roundForward(state, a1 ^ PRINCE_FAST_RC1);
+    state = prince_fast_roundForward(state, a0 ^ PRINCE_FAST_RC2);
+    state = prince_fast_roundForward(state, a1 ^ PRINCE_FAST_RC3);
+    state = prince_fast_roundForward(state, a0 ^ PRINCE_FAST_RC4);
+    state = prince_fast_roundForward(state, a1 ^ PRINCE_FAST_RC5);
+
+    state = prince_fast_s_layer(state) ^ a0;
+    state = prince_word_m_layer(state) ^ b1 ^ PRINCE_FAST_BETA;
+    state = prince_fast_s_layer_inverse(state);
+
+    state = prince_fast_roundInverse(state, b0 ^ PRINCE_FAST_RC6);
+    state = prince_fast_roundInverse(state, b1 ^ PRINCE_FAST_RC7);
+    state = prince_fast_roundInverse(state, b0 ^ PRINCE_FAST_RC8);
+    state = prince_fast_roundInverse(state, b1 ^ PRINCE_FAST_RC9);
+    state = prince_fast_roundInverse(state, b0 ^ PRINCE_FAST_RC10);
+
+    return state ^ b1 ^ PRINCE_FAST_BETA;
+}
+
+static inline uint64_t prince_encrypt_fast(princev2key_t key, uint64_t plaintext) {
+    return prince_fast_core(key.k0, key.k1, key.k0, key.k1, plaintext);
+}
+
+/* the decryption key of prince_decrypt is (k1 ^ BETA, k0 ^ ALPHA), its
+   second half is adjusted by ALPHA ^ BETA once more */
+static inline uint64_t prince_decrypt_fast(princev2key_t key, uint64_t ciphertext) {
+    return prince_fast_core(key.k1 ^ PRINCE_FAST_BETA, key.k0 ^ PRINCE_FAST_ALPHA,
+                            key.k1 ^ PRINCE_FAST_ALPHA, key.k0 ^ PRINCE_FAST_BETA,
+                            ciphertext);
+}
+
+#endif
@@ -0,0 +1,66 @@
+/**
+princev2layers.h
+
+Word level linear layers of PRINCEv2, header only
+
+M' and SR on the whole 64-bit state with shifts and masks instead of one
+nibble at a time. princev2.c builds prince_m_layer, prince_shiftRow and
+prince_shiftRowInverse on them, princev2fast.h inlines them into its
+unrolled rounds. Nibble 0 is the most significant one, column c is the
+16-bit word holding nibbles 4c to 4c + 3.
+**/
+
+#ifndef _PRINCE_LAYERS_
+#define _PRINCE_LAYERS_
+
+#include <stdint.h>
+
+/* the diagonal masks of M' (prince_m_mask in princev2.c) and the rows of
+   the state */
+#define PRINCE_M_MASK0 0x7d7dbebebebe7d7d
+#define PRINCE_M_MASK1 0xbebed7d7d7d7bebe
+#define PRINCE_M_MASK2 0xd7d7ebebebebd7d7
+#define PRINCE_M_MASK3 0xebeb7d7d7d7debeb
+
+#define PRINCE_ROW0 0xf000f000f000f000
+#define PRINCE_ROW1 0x0f000f000f000f00
+#define PRINCE_ROW2 0x00f000f000f000f0
+#define PRINCE_ROW3 0x000f000f000f000f
+
+/* every 16-bit column rotated left by bits, 0 < bits < 16 */
+static inline uint64_t prince_word_rotateColumns(uint64_t state, int bits) {
+    uint64_t wrapped = (((uint64_t) 1 << bits) - 1) * 0x0001000100010001;
+
+    return ((state << bits) & ~wrapped) | ((state >> (16 - bits)) & wrapped);
+}
+
+static inline uint64_t prince_word_rotateLeft(uint64_t state, int bits) {
+    return (state << bits) | (state >> (64 - bits));
+}
+
+/* M' as the XOR of the columns rotated up by 0 to 3 nibbles, see
+   prince_m_mask in princev2.c */
+static inline uint64_t prince_word_m_layer(uint64_t state) {
+    return (state & PRINCE_M_MASK0) ^
+           (prince_word_rotateColumns(state, 4) & PRINCE_M_MASK1) ^
+           (prince_word_rotateColumns(state, 8) & PRINCE_M_MASK2) ^
+           (prince_word_rotateColumns(state, 12) & PRINCE_M_MASK3);
+}
+
+/* SR moves row r of the state r columns to the left (prince_shift), that
+   is a rotation of the whole word by 16 r bits */
+static inline uint64_t prince_word_shiftRow(uint64_t state) {
+    return (state & PRINCE_ROW0) |
+           (prince_word_rotateLeft(state, 16) & PRINCE_ROW1) |
+           (prince_word_rotateLeft(state, 32) & PRINCE_ROW2) |
+           (prince_word_rotateLeft(state, 48) & PRINCE_ROW3);
+}
+
+static inline uint64_t prince_word_shiftRowInverse(uint64_t state) {
+    return (state & PRINCE_ROW0) |
+           (prince_word_rotateLeft(state, 48) & PRINCE_ROW1) |
+           (prince_word_rotateLeft(state, 32) & PRINCE_ROW2) |
+           (prince_word_rotateLeft(state, 16) & PRINCE_ROW3);
+}
+
+#endif
@@ -0,0 +1,392 @@
+/**
+princev2memsim.c
+
+This program replays a memory access trace against a simulated encrypted
+DRAM: every line written is encrypted with the address tweaked mode of
+princev2xex.h, every line read is decrypted and compared with what was
+last written to it. It reports lines per second of the replay.
+
+A trace has one access per line, "R <address>" or "W <address>" with a hex
+address ("0x" optional), blank lines and lines starting with '#' are
+skipped. Addresses are reduced to a line of the --memory bytes of
+simulated DRAM (64M by default), which start out as encrypted zeros.
+--random N replays N uniformly random accesses (a third of them writes)
+instead of a file.
+
+Accesses are replayed --batch at a time (1024 by default): the lines
+written in a batch are encrypted in one prince_xex_encrypt_lines call, then
+the batch is walked in order, writes storing their ciphertext and reads
+taking a copy of the current one, and the copies are decrypted in one
+prince_xex_decrypt_lines call. Every read therefore sees exactly the writes
+before it in the trace. --single does the same with one prince_encrypt or
+prince_decrypt call per block, as a baseline for the batched calls.
+
+Sample Usage:
+
+> princev2memsim trace.txt
+> princev2memsim --random 10000000 --single
+> princev2memsim - --key 0123456789abcdef fedcba9876543210 --memory 1G < trace.txt
+
+Sample build:
+> make princev2memsim
+**/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hex.h"
+#include "key.h"
+#include "princev2.h"
+#include "princev2xex.h"
+#include "prng.h"
+
+enum{DEFAULT_BATCH = 1024};
+#define DEFAULT_MEMORY_BYTES ((uint64_t) 64 << 20)
+
+/* longest trace line */
+enum{MAX_LINE = 256};
+
+typedef struct access {
+    uint64_t address;
+    int write;
+} access_t;
+
+typedef struct memsim {
+    princev2key_t key;
+    princev2ctx_t ctx;
+    int single;
+    uint64_t lines;       /* lines of simulated DRAM */
+    uint64_t* memory;     /* ciphertext */
+    uint64_t* shadow;     /* plaintext last written */
+
+    /* per batch */
+    size_t batch;
+    uint64_t* writeAddress;
+    uint64_t* writeLines;
+    uint64_t* readAddress;
+    uint64_t* readLines;
+    uint64_t* readExpected;
+
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t errors;
+} memsim_t;
+
+static double seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* prince_xex_encrypt_lines/prince_xex_decrypt_lines one block at a time */
+static void singleLines(princev2key_t key, princemode_t mode, const uint64_t* addresses,
+                        const uint64_t* in, uint64_t* out, size_t lines) {
+    for (size_t i = 0; i < lines; i++) {
+        uint64_t d = prince_encrypt(key, addresses[i] / XEX_LINE_BYTES);
+
+        for (size_t j = 0; j < XEX_LINE_BLOCKS; j++) {
+            size_t b = i * XEX_LINE_BLOCKS + j;
+
+            d = prince_xex_double(d);
+            out[b] = (mode == ENC ? prince_encrypt(key, in[b] ^ d)
+                                  : prince_decrypt(key, in[b] ^ d)) ^ d;
+        }
+    }
+}
+
+static void cryptLines(const memsim_t* sim, princemode_t mode, const uint64_t* addresses,
+                       const uint64_t* in, uint64_t* out, size_t lines) {
+    if (sim->single) {
+        singleLines(sim->key, mode, addresses, in, out, lines);
+    } else if (mode == ENC) {
+        prince_xex_encrypt_lines(&sim->ctx, addresses, in, out, lines);
+    } else {
+        prince_xex_decrypt_lines(&sim->ctx, addresses, in, out, lines);
+    }
+}
+
+/* address of the simulated line that address falls into */
+static inline uint64_t lineAddress(const memsim_t* sim, uint64_t address) {
+    return (address / XEX_LINE_BYTES % sim->lines) * XEX_LINE_BYTES;
+}
+
+static void replayBatch(memsim_t* sim, const access_t* accesses, size_t n,
+                        uint64_t sequence) {
+    size_t w = 0, r = 0;
+
+    /* fresh data for every write */
+    for (size_t i = 0; i < n; i++) {
+        if (accesses[i].write) {
+            sim->writeAddress[w] = lineAddress(sim, accesses[i].address);
+            for (size_t j = 0; j < XEX_LINE_BLOCKS; j++) {
+                sim->writeLines[w * XEX_LINE_BLOCKS + j] =
+                    ((sequence + i) << 3 | j) ^ sim->writeAddress[w];
+            }
+            w++;
+        }
+    }
+    cryptLines(sim, ENC, sim->writeAddress, sim->writeLines, sim->writeLines, w);
+
+    w = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t address = lineAddress(sim, accesses[i].address);
+        size_t line = address / XEX_LINE_BYTES * XEX_LINE_BLOCKS;
+
+        if (accesses[i].write) {
+            memcpy(sim->memory + line, sim->writeLines + w * XEX_LINE_BLOCKS, XEX_LINE_BYTES);
+            for (size_t j = 0; j < XEX_LINE_BLOCKS; j++) {
+                sim->shadow[line + j] = ((sequence + i) << 3 | j) ^ address;
+            }
+            w++;
+        } else {
+            sim->readAddress[r] = address;
+            memcpy(sim->readLines + r * XEX_LINE_BLOCKS, sim->memory + line, XEX_LINE_BYTES);
+            memcpy(sim->readExpected + r * XEX_LINE_BLOCKS, sim->shadow + line,
+                   XEX_LINE_BYTES);
+            r++;
+        }
+    }
+    cryptLines(sim, DEC, sim->readAddress, sim->readLines, sim->readLines, r);
+
+    for (size_t i = 0; i < r; i++) {
+        sim->errors += memcmp(sim->readLines + i * XEX_LINE_BLOCKS,
+                              sim->readExpected + i * XEX_LINE_BLOCKS, XEX_LINE_BYTES) != 0;
+    }
+
+    sim->reads += r;
+    sim->writes += w;
+}
+
+/* parses one trace line into access. Returns 1 for an access, 0 for a
+   line without one and -1 if no access can be read from it */
+static int parseAccess(const char* line, access_t* access) {
+    while (isspace((unsigned char) *line)) {
+        line++;
+    }
+    if (*line == '\0' || *line == '#') {
+        return 0;
+    }
+
+    char type = toupper((unsigned char) *line++);
+    char* end;
+
+    if ((type != 'R' && type != 'W') || !isspace((unsigned char) *line)) {
+        return -1;
+    }
+
+    access->write = type == 'W';
+    access->address = strtoull(line, &end, 16);
+
+    while (isspace((unsigned char) *end)) {
+        end++;
+    }
+
+    return end == line || *end != '\0' ? -1 : 1;
+}
+
+/* reads the whole trace from file into *accesses.
+   returns the number of accesses or -1 on error */
+static ssize_t loadTrace(FILE* file, access_t** accesses) {
+    char line[MAX_LINE];
+    size_t n = 0, capacity = 1 << 16;
+    size_t number = 0;
+
+    *accesses = malloc(capacity * sizeof(access_t));
+    if (*accesses == NULL) {
+        fprintf(stderr, "loadTrace: out of memory\n");
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        number++;
+
+        if (n == capacity) {
+            access_t* grown = realloc(*accesses, 2 * capacity * sizeof(access_t));
+            if (grown == NULL) {
+                fprintf(stderr, "loadTrace: out of memory\n");
+                return -1;
+            }
+            *accesses = grown;
+            capacity *= 2;
+        }
+
+        int parsed = parseAccess(line, *accesses + n);
+        if (parsed < 0) {
+            fprintf(stderr, "loadTrace: cannot parse line %zu: %s", number, line);
+            return -1;
+        }
+        n += parsed;
+    }
+
+    return n;
+}
+
+/* n accesses to random lines of the simulated memory, a third of them writes */
+static access_t* randomTrace(const memsim_t* sim, size_t n) {
+    access_t* accesses = malloc(n * sizeof(access_t));
+    prng_t prng;
+
+    if (accesses == NULL) {
+        fprintf(stderr, "randomTrace: out of memory\n");
+        return NULL;
+    }
+
+    prng_seed(&prng, 0);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t r = prng_next(&prng);
+
+        accesses[i].address = (r >> 8) % sim->lines * XEX_LINE_BYTES;
+        accesses[i].write = (r & 0xff) < 0x55;
+    }
+
+    return accesses;
+}
+
+/* allocates the simulated memory and the batch buffers, the memory holds
+   encrypted zeros. Returns 0 if no error */
+static int initMemory(memsim_t* sim) {
+    size_t blocks = sim->lines * XEX_LINE_BLOCKS;
+    size_t batchBlocks = sim->batch * XEX_LINE_BLOCKS;
+
+    sim->memory = malloc(blocks * sizeof(uint64_t));
+    sim->shadow = calloc(blocks, sizeof(uint64_t));
+    sim->writeAddress = malloc(sim->batch * sizeof(uint64_t));
+    sim->readAddress = malloc(sim->batch * sizeof(uint64_t));
+    sim->writeLines = malloc(batchBlocks * sizeof(uint64_t));
+    sim->readLines = malloc(batchBlocks * sizeof(uint64_t));
+    sim->readExpected = malloc(batchBlocks * sizeof(uint64_t));
+
+    if (sim->memory == NULL || sim->shadow == NULL || sim->writeAddress == NULL ||
+        sim->readAddress == NULL || sim->writeLines == NULL || sim->readLines == NULL ||
+        sim->readExpected == NULL) {
+        fprintf(stderr, "initMemory: out of memory\n");
+        return -1;
+    }
+
+    for (uint64_t line = 0; line < sim->lines; line += sim->batch) {
+        size_t count = sim->lines - line < sim->batch ? sim->lines - line : sim->batch;
+
+        for (size_t i = 0; i < count; i++) {
+            sim->writeAddress[i] = (line + i) * XEX_LINE_BYTES;
+        }
+        prince_xex_encrypt_lines(&sim->ctx, sim->writeAddress,
+                                 sim->shadow + line * XEX_LINE_BLOCKS,
+                                 sim->memory + line * XEX_LINE_BLOCKS, count);
+    }
+
+    return 0;
+}
+
+/* parses a byte count with an optional K, M or G suffix.
+   returns 0 if no error */
+static int parseSize(const char* str, uint64_t* size) {
+    char* end;
+    unsigned long long value = strtoull(str, &end, 10);
+
+    switch (*end) {
+    case 'G': case 'g': value <<= 10; /* fall through */
+    case 'M': case 'm': value <<= 10; /* fall through */
+    case 'K': case 'k': value <<= 10; end++; break;
+    }
+
+    if (end == str || *end != '\0' || value < XEX_LINE_BYTES) {
+        fprintf(stderr, "failed to parse size %s\n", str);
+        return -1;
+    }
+
+    *size = value;
+    return 0;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s {<trace>|-|--random N} [--key k0 k1] [--memory size[K|M|G]] "
+            "[--batch lines] [--single]\n", name);
+}
+
+int main(int argc, char* argv[]) {
+    static memsim_t sim;
+    uint64_t memoryBytes = DEFAULT_MEMORY_BYTES;
+    const char* trace = NULL;
+    size_t randomAccesses = 0;
+
+    sim.key = key_new(0x0123456789abcdef, 0xfedcba9876543210);
+    sim.batch = DEFAULT_BATCH;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--random") && i + 1 < argc) {
+            randomAccesses = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--key") && i + 2 < argc) {
+            if (hex_parse(argv[i + 1], strlen(argv[i + 1]), &sim.key.k0) != 0 ||
+                hex_parse(argv[i + 2], strlen(argv[i + 2]), &sim.key.k1) != 0) {
+                fprintf(stderr, "failed to parse key %s %s\n", argv[i + 1], argv[i + 2]);
+                return -1;
+            }
+            i += 2;
+        } else if (!strcmp(argv[i], "--memory") && i + 1 < argc) {
+            if (parseSize(argv[++i], &memoryBytes) != 0) {
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "--batch") && i + 1 < argc) {
+            sim.batch = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--single")) {
+            sim.single = 1;
+        } else if (trace == NULL && (argv[i][0] != '-' || !strcmp(argv[i], "-"))) {
+            trace = argv[i];
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if ((trace == NULL) == (randomAccesses == 0) || sim.batch == 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    sim.lines = memoryBytes / XEX_LINE_BYTES;
+    prince_ctx_init(&sim.ctx, sim.key);
+    if (initMemory(&sim) != 0) {
+        return -1;
+    }
+
+    access_t* accesses;
+    ssize_t n;
+
+    if (trace != NULL) {
+        FILE* file = strcmp(trace, "-") ? fopen(trace, "r") : stdin;
+        if (file == NULL) {
+            fprintf(stderr, "cannot open %s\n", trace);
+            return -1;
+        }
+        n = loadTrace(file, &accesses);
+        if (file != stdin) {
+            fclose(file);
+        }
+    } else {
+        accesses = randomTrace(&sim, randomAccesses);
+        n = accesses == NULL ? -1 : (ssize_t) randomAccesses;
+    }
+    if (n < 0) {
+        return -1;
+    }
+
+    double start = seconds();
+    for (size_t i = 0; i < (size_t) n; i += sim.batch) {
+        replayBatch(&sim, accesses + i, (size_t) n - i < sim.batch ? (size_t) n - i : sim.batch,
+                    i);
+    }
+    double elapsed = seconds() - start;
+
+    printf("accesses %zd reads %" PRIu64 " writes %" PRIu64 " errors %" PRIu64 "\n", n,
+           sim.reads, sim.writes, sim.errors);
+    printf("%s: %.3f s, %.4g lines/s, %.1f MB/s\n",
+           sim.single ? "single-block calls" : "batched lines", elapsed, n / elapsed,
+           n * (double) XEX_LINE_BYTES / elapsed / 1e6);
+
+    free(accesses);
+    return sim.errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/**
+princev2pmac.c
+
+Parallelizable MAC (PMAC1) on top of PRINCEv2
+
+Full blocks are masked with their offsets in tiles of PMAC_TILE_BLOCKS,
+every tile is encrypted with one engine call and folded into the sum. The
+offset of block i follows from that of block i - 1 by one XOR with
+L * x^ntz(i), and the offset of any block can be computed directly from
+its Gray code, so long updates are cut into one range per thread like in
+princev2ctr.c and the partial sums of the ranges are XORed.
+**/
+
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "princev2pmac.h"
+#include "princev2ctr.h"
+#include "princev2engine.h"
+#include "princev2xex.h"
+#include "misc.h"
+
+/* blocks per tile, a multiple of every engine's batch size */
+enum {PMAC_TILE_BLOCKS = 1024};
+
+/* ranges smaller than this are not worth a thread */
+enum {PMAC_MIN_BLOCKS_PER_THREAD = 16 * PMAC_TILE_BLOCKS};
+
+enum {PMAC_MAX_THREADS = 256};
+
+typedef struct pmacjob {
+    const princev2pmackey_t* key;
+    uint64_t first;       /* index of the first block, starting at 1 */
+    const uint8_t* data;
+    size_t n;
+    uint64_t sum;
+} pmacjob_t;
+
+/* Delta_i = gamma(i) * L */
+static uint64_t prince_pmac_offset(const princev2pmackey_t* key, uint64_t i) {
+    uint64_t offset = 0;
+
+    for (uint64_t gray = i ^ (i >> 1); gray != 0; gray &= gray - 1) {
+        offset ^= key->l[__builtin_ctzll(gray)];
+    }
+
+    return offset;
+}
+
+static void prince_pmac_run(pmacjob_t* job) {
+    uint64_t tile[PMAC_TILE_BLOCKS];
+    uint64_t offset = prince_pmac_offset(job->key, job->first - 1);
+    uint64_t index = job->first;
+    const uint8_t* data = job->data;
+    uint64_t sum = 0;
+
+    for (size_t done = 0; done < job->n; done += PMAC_TILE_BLOCKS) {
+        size_t count = job->n - done < PMAC_TILE_BLOCKS ? job->n - done : PMAC_TILE_BLOCKS;
+
+        for (size_t i = 0; i < count; i++, index++) {
+            offset ^= job->key->l[__builtin_ctzll(index)];
+            tile[i] = loadBigEndian(data + i * PMAC_BLOCK_BYTES) ^ offset;
+        }
+
+        prince_engine_encrypt_ctx(PRINCE_ENGINE_AUTO, &job->key->ctx, tile, tile, count);
+
+        for (size_t i = 0; i < count; i++) {
+            sum ^= tile[i];
+        }
+
+        data += count * PMAC_BLOCK_BYTES;
+    }
+
+    job->sum = sum;
+}
+
+static void* prince_pmac_worker(void* arg) {
+    prince_pmac_run((pmacjob_t*) arg);
+    return NULL;
+}
+
+/* adds n full blocks of data to the sum, on up to pmac->threads threads */
+static void prince_pmac_blocks(princev2pmac_t* pmac, const uint8_t* data, size_t n) {
+    pmacjob_t jobs[PMAC_MAX_THREADS];
+    pthread_t tids[PMAC_MAX_THREADS];
+    int started[PMAC_MAX_THREADS];
+    int threads = pmac->threads;
+
+    /* short updates do not ask for the number of CPUs, it is a system call */
+    if (n < 2 * PMAC_MIN_BLOCKS_PER_THREAD) {
+        threads = 1;
+    } else if (threads <= 0) {
+        threads = prince_ctr_threads();
+    }
+    if (threads > PMAC_MAX_THREADS) {
+        threads = PMAC_MAX_THREADS;
+    }
+    if ((size_t) threads > n / PMAC_MIN_BLOCKS_PER_THREAD) {
+        threads = n / PMAC_MIN_BLOCKS_PER_THREAD;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    size_t tiles = (n + PMAC_TILE_BLOCKS - 1) / PMAC_TILE_BLOCKS;
+    size_t start = 0;
+
+    for (int t = 0; t < threads; t++) {
+        size_t end = (tiles * (t + 1) / threads) * PMAC_TILE_BLOCKS;
+        if (end > n) {
+            end = n;
+        }
+
+        jobs[t].key = pmac->key;
+        jobs[t].first = pmac->blocks + 1 + start;
+        jobs[t].data = data + start * PMAC_BLOCK_BYTES;
+        jobs[t].n = end - start;
+        start = end;
+    }
+
+    /* the calling thread takes the first range itself */
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&tids[t], NULL, prince_pmac_worker, &jobs[t]) == 0;
+    }
+
+    prince_pmac_run(&jobs[0]);
+    pmac->sum ^= jobs[0].sum;
+
+    /* ranges whose thread failed to start are done here */
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            prince_pmac_run(&jobs[t]);
+        }
+        pmac->sum ^= jobs[t].sum;
+    }
+
+    pmac->blocks += n;
+}
+
+void prince_pmac_key(princev2pmackey_t* pmacKey, princev2key_t key) {
+    assert(pmacKey != NULL);
+
+    prince_ctx_init(&pmacKey->ctx, key);
+
+    uint64_t l = prince_encrypt_ctx(&pmacKey->ctx, 0);
+    pmacKey->l[0] = l;
+    for (int j = 1; j < 64; j++) {
+        pmacKey->l[j] = prince_xex_double(pmacKey->l[j - 1]);
+    }
+
+    /* L / x: x^64 = x^4 + x^3 + x + 1, so x^-1 = x^63 + x^3 + x^2 + 1 */
+    pmacKey->lInverse = (l >> 1) ^ (-(l & 1) & 0x800000000000000d);
+}
+
+void prince_pmac_init(princev2pmac_t* pmac, const princev2pmackey_t* pmacKey, int threads) {
+    assert(pmac != NULL && pmacKey != NULL);
+
+    pmac->key = pmacKey;
+    pmac->sum = 0;
+    pmac->blocks = 0;
+    pmac->buffered = 0;
+    pmac->threads = threads;
+}
+
+void prince_pmac_update(princev2pmac_t* pmac, const uint8_t* data, size_t len) {
+    assert(pmac != NULL && (data != NULL || len == 0));
+
+    if (pmac->buffered + len <= PMAC_BLOCK_BYTES) {
+        memcpy(pmac->buffer + pmac->buffered, data, len);
+        pmac->buffered += len;
+        return;
+    }
+
+    /* more data follows, so the buffered block is not the last one */
+    if (pmac->buffered > 0) {
+        size_t fill = PMAC_BLOCK_BYTES - pmac->buffered;
+
+        memcpy(pmac->buffer + pmac->buffered, data, fill);
+        prince_pmac_blocks(pmac, pmac->buffer, 1);
+        data += fill;
+        len -= fill;
+    }
+
+    /* 1 to PMAC_BLOCK_BYTES bytes stay buffered */
+    size_t n = (len - 1) / PMAC_BLOCK_BYTES;
+    prince_pmac_blocks(pmac, data, n);
+
+    pmac->buffered = len - n * PMAC_BLOCK_BYTES;
+    memcpy(pmac->buffer, data + n * PMAC_BLOCK_BYTES, pmac->buffered);
+}
+
+uint64_t prince_pmac_final(princev2pmac_t* pmac) {
+    assert(pmac != NULL);
+
+    uint64_t sum = pmac->sum;
+
+    if (pmac->buffered == PMAC_BLOCK_BYTES) {
+        sum ^= loadBigEndian(pmac->buffer) ^ pmac->key->lInverse;
+    } else {
+        uint64_t last = (uint64_t) 0x80 << (8 * (PMAC_BLOCK_BYTES - 1 - pmac->buffered));
+
+        for (size_t b = 0; b < pmac->buffered; b++) {
+            last |= (uint64_t) pmac->buffer[b] << (8 * (PMAC_BLOCK_BYTES - 1 - b));
+        }
+        sum ^= last;
+    }
+
+    return prince_encrypt_ctx(&pmac->key->ctx, sum);
+}
+
+uint64_t prince_pmac(const princev2pmackey_t* pmacKey, const uint8_t* data, size_t len,
+                     int threads) {
+    princev2pmac_t pmac;
+
+    prince_pmac_init(&pmac, pmacKey, threads);
+    prince_pmac_update(&pmac, data, len);
+    return prince_pmac_final(&pmac);
+}
@@ -0,0 +1,66 @@
+/**
+princev2pmac.h
+
+Interface for a parallelizable MAC (PMAC1) on top of PRINCEv2
+
+The message is cut into 64-bit blocks M_1..M_m, read most significant byte
+first, the last one 1 to 8 bytes long (an empty message has one empty
+block). With L = E(0) and the offsets Delta_i = gamma(i) * L, gamma(i) the
+Gray code i ^ (i >> 1) as an element of
+GF(2^64) = GF(2)[x] / (x^64 + x^4 + x^3 + x + 1),
+
+    Sigma = E(M_1 ^ Delta_1) ^ ... ^ E(M_{m-1} ^ Delta_{m-1}) ^ last,
+    tag   = E(Sigma ^ M_m ^ L / x)      if M_m is a full block,
+    tag   = E(Sigma ^ M_m || 10..0)     otherwise.
+
+All encryptions but the last are independent, so they go through the
+batch engines and, for long messages, several threads.
+**/
+
+#ifndef _PRINCE_PMAC_
+#define _PRINCE_PMAC_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "princev2.h"
+
+enum {PMAC_BLOCK_BYTES = sizeof(uint64_t)};
+
+/* expanded key: L * x^j for every offset a message can reach, and L / x */
+typedef struct pmackey {
+    princev2ctx_t ctx;
+    uint64_t l[64];
+    uint64_t lInverse;
+} princev2pmackey_t;
+
+/* state of one message. update keeps the last block back, it is only
+   known to be the last one in prince_pmac_final */
+typedef struct pmac {
+    const princev2pmackey_t* key;
+    uint64_t sum;
+    uint64_t blocks;   /* blocks added to sum */
+    uint8_t buffer[PMAC_BLOCK_BYTES];
+    size_t buffered;
+    int threads;
+} princev2pmac_t;
+
+/* expands key once, for any number of messages */
+void prince_pmac_key(princev2pmackey_t* pmacKey, princev2key_t key);
+
+/* starts a message under pmacKey, which has to outlive pmac.
+   threads = 0 uses one thread per online CPU for long updates */
+void prince_pmac_init(princev2pmac_t* pmac, const princev2pmackey_t* pmacKey, int threads);
+
+/* appends len bytes of data to the message */
+void prince_pmac_update(princev2pmac_t* pmac, const uint8_t* data, size_t len);
+
+/* returns the tag of the message, pmac has to be initialized again for the
+   next one */
+uint64_t prince_pmac_final(princev2pmac_t* pmac);
+
+/* prince_pmac_init, prince_pmac_update and prince_pmac_final in one call */
+uint64_t prince_pmac(const princev2pmackey_t* pmacKey, const uint8_t* data, size_t len,
+                     int threads);
+
+#endif
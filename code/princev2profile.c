@@ -0,0 +1,217 @@
+/**
+princev2profile.c
+
+Per-thread counters and the exit report of the PRINCEv2 instrumentation
+
+Every thread gets its own counters on its first profiled call. They are
+allocated once and never freed, so the report still sees the counts of
+threads that have finished. prince_profile_depth counts the cores the
+thread is in, layers outside of any core are not recorded.
+**/
+
+#include <stdio.h>
+
+#include "princev2profile.h"
+
+#ifdef PRINCE_PROFILE
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_HAVE_RDTSC 1
+#else
+#define PROFILE_HAVE_RDTSC 0
+#endif
+
+/* clock reads used to measure the cost of a clock read */
+enum {CALIBRATION_ROUNDS = 1000};
+
+typedef struct profilethread {
+    uint64_t calls[NUM_OF_PROFILE_COUNTERS];
+    uint64_t cycles[NUM_OF_PROFILE_COUNTERS];
+    struct profilethread* next;
+} profilethread_t;
+
+static const char* prince_profile_names[NUM_OF_PROFILE_COUNTERS] = {
+    [PRINCE_PROFILE_CORE]              = "prince_core",
+    [PRINCE_PROFILE_S_LAYER]           = "s_layer",
+    [PRINCE_PROFILE_M_LAYER]           = "m_layer",
+    [PRINCE_PROFILE_SHIFT_ROW]         = "shiftRow",
+    [PRINCE_PROFILE_SHIFT_ROW_INVERSE] = "shiftRowInverse",
+    [PRINCE_PROFILE_KEY_ADDITION]      = "key_addition",
+};
+
+static __thread profilethread_t* prince_profile_thread = NULL;
+static __thread int prince_profile_depth = 0;
+static profilethread_t* prince_profile_threads = NULL;
+static pthread_mutex_t prince_profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t prince_profile_cycles() {
+#if PROFILE_HAVE_RDTSC
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static profilethread_t* prince_profile_register() {
+    profilethread_t* thread = calloc(1, sizeof(profilethread_t));
+    if (thread == NULL) {
+        fprintf(stderr, "prince_profile_register: out of memory\n");
+        exit(-1);
+    }
+
+    pthread_mutex_lock(&prince_profile_lock);
+    thread->next = prince_profile_threads;
+    prince_profile_threads = thread;
+    pthread_mutex_unlock(&prince_profile_lock);
+
+    prince_profile_thread = thread;
+    return thread;
+}
+
+static void prince_profile_record(princeprofilecounter_t counter, uint64_t cycles) {
+    profilethread_t* thread = prince_profile_thread;
+
+    if (thread == NULL) {
+        thread = prince_profile_register();
+    }
+
+    thread->calls[counter]++;
+    thread->cycles[counter] += cycles;
+}
+
+void prince_profile_add(princeprofilecounter_t counter, uint64_t cycles) {
+    if (prince_profile_depth > 0) {
+        prince_profile_record(counter, cycles);
+    }
+}
+
+uint64_t prince_profile_enter() {
+    prince_profile_depth++;
+    return prince_profile_cycles();
+}
+
+/* only the outermost core is recorded, it includes the nested ones */
+void prince_profile_leave(uint64_t start) {
+    uint64_t cycles = prince_profile_cycles() - start;
+
+    if (--prince_profile_depth == 0) {
+        prince_profile_record(PRINCE_PROFILE_CORE, cycles);
+    }
+}
+
+/* smallest difference of two back to back clock reads */
+static uint64_t prince_profile_overhead() {
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < CALIBRATION_ROUNDS; i++) {
+        uint64_t start = prince_profile_cycles();
+        uint64_t elapsed = prince_profile_cycles() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+/* average cost of timing one layer inside a core, clock reads and
+   bookkeeping included, recorded into a scratch thread */
+static double prince_profile_nestedCost() {
+    profilethread_t scratch = {{0}};
+    profilethread_t* thread = prince_profile_thread;
+
+    prince_profile_thread = &scratch;
+    prince_profile_depth++;
+
+    uint64_t start = prince_profile_cycles();
+    for (int i = 0; i < CALIBRATION_ROUNDS; i++) {
+        PRINCE_PROFILE_STATEMENT(PRINCE_PROFILE_KEY_ADDITION, __asm__ volatile(""));
+    }
+    uint64_t elapsed = prince_profile_cycles() - start;
+
+    prince_profile_depth--;
+    prince_profile_thread = thread;
+
+    return (double) elapsed / CALIBRATION_ROUNDS;
+}
+
+void prince_profile_report() {
+    uint64_t calls[NUM_OF_PROFILE_COUNTERS] = {0};
+    double cycles[NUM_OF_PROFILE_COUNTERS] = {0};
+    double overhead = prince_profile_overhead();
+    double nested = prince_profile_nestedCost();
+
+    pthread_mutex_lock(&prince_profile_lock);
+    for (profilethread_t* t = prince_profile_threads; t != NULL; t = t->next) {
+        for (int c = 0; c < NUM_OF_PROFILE_COUNTERS; c++) {
+            calls[c] += t->calls[c];
+            cycles[c] += t->cycles[c];
+        }
+    }
+    pthread_mutex_unlock(&prince_profile_lock);
+
+    if (calls[PRINCE_PROFILE_CORE] == 0) {
+        return;
+    }
+
+    for (int c = 0; c < NUM_OF_PROFILE_COUNTERS; c++) {
+        cycles[c] -= overhead * calls[c];
+        if (cycles[c] < 0) {
+            cycles[c] = 0;
+        }
+    }
+
+    /* the layers run inside prince_core, timing them is part of it. What
+       is left of a layer's timing after its own count is the bookkeeping */
+    double core = cycles[PRINCE_PROFILE_CORE];
+    for (int c = PRINCE_PROFILE_CORE + 1; c < NUM_OF_PROFILE_COUNTERS; c++) {
+        core -= (nested > overhead ? nested : overhead) * calls[c];
+    }
+    if (core < 0) {
+        core = 0;
+    }
+
+    fprintf(stderr, "\nPRINCEv2 profile (%s, %.0f subtracted per call, %.0f per layer from "
+            "the core)\n", PROFILE_HAVE_RDTSC ? "TSC ticks" : "nanoseconds", overhead, nested);
+    fprintf(stderr, "%-16s %14s %16s %12s %8s\n", "layer", "calls", "cycles",
+            "cycles/call", "of core");
+
+    double layers = 0;
+    for (int c = 0; c < NUM_OF_PROFILE_COUNTERS; c++) {
+        double value = c == PRINCE_PROFILE_CORE ? core : cycles[c];
+
+        if (c != PRINCE_PROFILE_CORE) {
+            layers += value;
+        }
+
+        fprintf(stderr, "%-16s %14lu %16.0f %12.1f %7.1f%%\n", prince_profile_names[c],
+                calls[c], value, calls[c] ? value / calls[c] : 0.0,
+                core > 0 ? 100 * value / core : 0.0);
+    }
+
+    /* every layer runs inside a core, only the estimate of the clock
+       overhead can take other below 0 */
+    double other = core > layers ? core - layers : 0;
+    fprintf(stderr, "%-16s %14s %16.0f %12s %7.1f%%\n", "other", "", other, "",
+            core > 0 ? 100 * other / core : 0.0);
+}
+
+__attribute__((constructor))
+static void prince_profile_init(void) {
+    atexit(prince_profile_report);
+}
+
+#else
+
+void prince_profile_report() {
+}
+
+#endif
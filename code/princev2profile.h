@@ -0,0 +1,78 @@
+/**
+princev2profile.h
+
+Compile-time instrumentation of the reference PRINCEv2 layers
+
+Built with -DPRINCE_PROFILE (make PROFILE=1), prince_s_layer,
+prince_m_layer, prince_shiftRow, prince_shiftRowInverse, the key additions
+of prince_core and prince_core_rounds, and the cores themselves (also
+through prince_core_ctx) count their calls and cycles, and a breakdown is
+printed to stderr at exit. Without it every macro below expands to
+nothing.
+
+A layer only counts while its thread is inside a core, so the layers
+called by table setup and the like stay out of the breakdown, and a core
+called from another core counts once. The table, bitsliced and SIMD
+engines do not run the cores at all; profile a workload with
+PRINCEV2_ENGINE=reference.
+
+Counters are per thread and summed for the report. Cycles are rdtsc ticks
+on x86 and nanoseconds elsewhere, with the cost of reading the clock
+subtracted. A single key addition is far cheaper than reading the clock,
+so its numbers are only good for call counts and rough comparisons. The
+cost of timing a layer, measured at exit, is taken off the core, so the
+"other" row is what runs between the layers.
+**/
+
+#ifndef _PRINCE_PROFILE_
+#define _PRINCE_PROFILE_
+
+#include <stdint.h>
+
+typedef enum {
+    PRINCE_PROFILE_CORE = 0,
+    PRINCE_PROFILE_S_LAYER,
+    PRINCE_PROFILE_M_LAYER,
+    PRINCE_PROFILE_SHIFT_ROW,
+    PRINCE_PROFILE_SHIFT_ROW_INVERSE,
+    PRINCE_PROFILE_KEY_ADDITION,
+    NUM_OF_PROFILE_COUNTERS
+} princeprofilecounter_t;
+
+/* prints the breakdown to stderr, does nothing without PRINCE_PROFILE */
+void prince_profile_report();
+
+#ifdef PRINCE_PROFILE
+
+uint64_t prince_profile_cycles();
+void prince_profile_add(princeprofilecounter_t counter, uint64_t cycles);
+uint64_t prince_profile_enter();
+void prince_profile_leave(uint64_t start);
+
+/* times the rest of a core up to PRINCE_PROFILE_CORE_END */
+#define PRINCE_PROFILE_CORE_BEGIN() uint64_t prince_profile_core = prince_profile_enter()
+#define PRINCE_PROFILE_CORE_END() prince_profile_leave(prince_profile_core)
+
+/* times the rest of the function body up to PRINCE_PROFILE_END */
+#define PRINCE_PROFILE_BEGIN() uint64_t prince_profile_start = prince_profile_cycles()
+#define PRINCE_PROFILE_END(counter) \
+    prince_profile_add(counter, prince_profile_cycles() - prince_profile_start)
+
+/* times a single statement */
+#define PRINCE_PROFILE_STATEMENT(counter, statement) do { \
+        uint64_t prince_profile_statement = prince_profile_cycles(); \
+        statement; \
+        prince_profile_add(counter, prince_profile_cycles() - prince_profile_statement); \
+    } while (0)
+
+#else
+
+#define PRINCE_PROFILE_BEGIN()
+#define PRINCE_PROFILE_END(counter)
+#define PRINCE_PROFILE_CORE_BEGIN()
+#define PRINCE_PROFILE_CORE_END()
+#define PRINCE_PROFILE_STATEMENT(counter, statement) statement
+
+#endif
+
+#endif
@@ -0,0 +1,300 @@
+/**
+princev2search.c
+
+This program recovers a PRINCEv2 key of which only some bits are unknown
+from known plaintext/ciphertext pairs, by trying every value of the
+unknown bits on all cores.
+
+Sample Usage:
+
+Search the lowest 12 bits of k0 and of k1 of the key 0123456789abcdef
+fedcba9876543210 with the pair p = 0123456789abcdef, c = 603cd95fa72a8704
+(the known bits of --base are kept, its unknown bits are ignored):
+> princev2search 0000000000000fff 0000000000000fff 0123456789abcdef 603cd95fa72a8704 \
+      --base 0123456789abcdef fedcba9876543210
+
+General form, with more pairs to tell false positives apart:
+> princev2search <mask k0> <mask k1> <p1> <c1> [<p2> <c2> ...] [--base k0 k1]
+      [--threads T] [--all]
+
+The candidates are numbered from 0 to 2^u - 1, u being the number of bits
+set in the masks, and handed out to the threads in chunks of SEARCH_CHUNK.
+Within a chunk the next key is the previous one plus one in the unknown
+bits (the low mask of k0 counts first), so a key costs two word operations
+on top of its encryption. Keys are encrypted SEARCH_BLOCKS at a time with
+prince_encrypt_keys_blocks, every key in its own SIMD lane, and compared
+with the first pair only; the few survivors are checked against the other
+pairs one by one. Matching keys go to stdout, progress and keys/second to
+stderr. The search stops at the first key matching every pair unless --all
+is given.
+
+Sample build:
+> make princev2search
+**/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hex.h"
+#include "key.h"
+#include "princev2.h"
+
+/* keys per engine call and per chunk handed to a thread */
+enum{SEARCH_BLOCKS = 4096};
+#define SEARCH_CHUNK ((uint64_t) 1 << 22)
+
+enum{MAX_THREADS = 256};
+enum{MAX_PAIRS = 16};
+enum{MAX_UNKNOWN_BITS = 63};
+
+/* seconds between progress lines */
+enum{PROGRESS_SECONDS = 10};
+
+typedef struct search {
+    princev2key_t base;
+    uint64_t mask[2];
+    uint64_t plain[MAX_PAIRS];
+    uint64_t cipher[MAX_PAIRS];
+    int pairs;
+    int all;
+    uint64_t candidates;
+
+    /* shared between the threads */
+    uint64_t nextChunk;
+    uint64_t tested;
+    uint64_t found;
+    int stop;
+    pthread_mutex_t lock;
+} search_t;
+
+typedef struct searchworker {
+    search_t* search;
+    pthread_t tid;
+} searchworker_t;
+
+static double seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* scatters the bits of index over the set bits of mask[0], then mask[1] */
+static princev2key_t keyFromIndex(const search_t* s, uint64_t index) {
+    uint64_t word[2] = {0, 0};
+
+    for (int w = 0; w < 2; w++) {
+        for (uint64_t m = s->mask[w]; m != 0; m &= m - 1) {
+            word[w] |= (index & 1) ? m & -m : 0;
+            index >>= 1;
+        }
+    }
+
+    return key_new((s->base.k0 & ~s->mask[0]) | word[0], (s->base.k1 & ~s->mask[1]) | word[1]);
+}
+
+/* adds one to the unknown bits of key, carrying from k0 into k1 */
+static inline void keyIncrement(const search_t* s, princev2key_t* key) {
+    uint64_t k0 = ((key->k0 | ~s->mask[0]) + 1) & s->mask[0];
+
+    if (k0 == 0) {
+        key->k1 = (key->k1 & ~s->mask[1]) | (((key->k1 | ~s->mask[1]) + 1) & s->mask[1]);
+    }
+    key->k0 = (key->k0 & ~s->mask[0]) | k0;
+}
+
+/* returns nonzero if key maps every pair after the first */
+static int checkPairs(const search_t* s, princev2key_t key) {
+    for (int i = 1; i < s->pairs; i++) {
+        if (prince_encrypt(key, s->plain[i]) != s->cipher[i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void reportKey(search_t* s, princev2key_t key) {
+    pthread_mutex_lock(&s->lock);
+    printf("%016lx %016lx\n", key.k0, key.k1);
+    fflush(stdout);
+    s->found++;
+    if (!s->all) {
+        __atomic_store_n(&s->stop, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void searchChunk(search_t* s, uint64_t first, uint64_t count) {
+    princev2key_t keys[SEARCH_BLOCKS];
+    uint64_t plain[SEARCH_BLOCKS], cipher[SEARCH_BLOCKS];
+    princev2key_t key = keyFromIndex(s, first);
+
+    for (size_t i = 0; i < SEARCH_BLOCKS; i++) {
+        plain[i] = s->plain[0];
+    }
+
+    while (count > 0) {
+        size_t n = count < SEARCH_BLOCKS ? count : SEARCH_BLOCKS;
+
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = key;
+            keyIncrement(s, &key);
+        }
+
+        prince_encrypt_keys_blocks(keys, plain, cipher, n);
+
+        for (size_t i = 0; i < n; i++) {
+            if (cipher[i] == s->cipher[0] && checkPairs(s, keys[i])) {
+                reportKey(s, keys[i]);
+            }
+        }
+
+        count -= n;
+    }
+}
+
+static void* runWorker(void* arg) {
+    search_t* s = ((searchworker_t*) arg)->search;
+
+    while (!__atomic_load_n(&s->stop, __ATOMIC_RELAXED)) {
+        uint64_t chunk = __atomic_fetch_add(&s->nextChunk, 1, __ATOMIC_RELAXED);
+        uint64_t first = chunk * SEARCH_CHUNK;
+
+        if (first >= s->candidates) {
+            break;
+        }
+
+        uint64_t count = s->candidates - first < SEARCH_CHUNK ? s->candidates - first
+                                                               : SEARCH_CHUNK;
+        searchChunk(s, first, count);
+        __atomic_fetch_add(&s->tested, count, __ATOMIC_RELAXED);
+    }
+
+    return NULL;
+}
+
+/* parses a hex word, name is used in the error message.
+   returns 0 if no error */
+static int parseWord(const char* str, const char* name, uint64_t* value) {
+    if (hex_parse(str, strlen(str), value) != 0) {
+        fprintf(stderr, "failed to parse %s = %s\n", name, str);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s <mask k0> <mask k1> <p1> <c1> [<p2> <c2> ...] [--base k0 k1] "
+            "[--threads T] [--all]\n", name);
+}
+
+int main(int argc, char* argv[]) {
+    static search_t s;
+    static searchworker_t workers[MAX_THREADS];
+    int threads = 0;
+    int i;
+
+    if (argc < 5) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if (parseWord(argv[1], "mask k0", &s.mask[0]) != 0 ||
+        parseWord(argv[2], "mask k1", &s.mask[1]) != 0) {
+        return -1;
+    }
+
+    for (i = 3; i + 1 < argc && strncmp(argv[i], "--", 2) != 0; i += 2) {
+        if (s.pairs == MAX_PAIRS) {
+            fprintf(stderr, "at most %d pairs\n", MAX_PAIRS);
+            return -1;
+        }
+        if (parseWord(argv[i], "plaintext", &s.plain[s.pairs]) != 0 ||
+            parseWord(argv[i + 1], "ciphertext", &s.cipher[s.pairs]) != 0) {
+            return -1;
+        }
+        s.pairs++;
+    }
+
+    for (; i < argc; i++) {
+        if (!strcmp(argv[i], "--base") && i + 2 < argc) {
+            if (parseWord(argv[i + 1], "k0", &s.base.k0) != 0 ||
+                parseWord(argv[i + 2], "k1", &s.base.k1) != 0) {
+                return -1;
+            }
+            i += 2;
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--all")) {
+            s.all = 1;
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    int unknown = __builtin_popcountll(s.mask[0]) + __builtin_popcountll(s.mask[1]);
+    if (s.pairs == 0 || unknown > MAX_UNKNOWN_BITS) {
+        fprintf(stderr, "need at least one pair and at most %d unknown bits\n",
+                MAX_UNKNOWN_BITS);
+        return -1;
+    }
+    s.candidates = (uint64_t) 1 << unknown;
+
+    if (threads <= 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    pthread_mutex_init(&s.lock, NULL);
+    fprintf(stderr, "searching 2^%d keys with %d pairs on %d threads\n", unknown, s.pairs,
+            threads);
+
+    double start = seconds();
+    for (int t = 0; t < threads; t++) {
+        workers[t].search = &s;
+        if (pthread_create(&workers[t].tid, NULL, runWorker, &workers[t]) != 0) {
+            fprintf(stderr, "cannot start thread %d\n", t);
+            return -1;
+        }
+    }
+
+    /* the workers only stop for good, so polling the counters is enough */
+    double lastReport = start;
+    while (__atomic_load_n(&s.tested, __ATOMIC_RELAXED) < s.candidates &&
+           !__atomic_load_n(&s.stop, __ATOMIC_RELAXED)) {
+        struct timespec pause = {0, 100000000};
+        nanosleep(&pause, NULL);
+
+        double now = seconds();
+        uint64_t tested = __atomic_load_n(&s.tested, __ATOMIC_RELAXED);
+        if (now - lastReport >= PROGRESS_SECONDS && tested > 0) {
+            fprintf(stderr, "%.1f%% tested, %.3g keys/s, %.0f s left\n",
+                    100.0 * tested / s.candidates, tested / (now - start),
+                    (s.candidates - tested) * (now - start) / tested);
+            lastReport = now;
+        }
+    }
+
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t].tid, NULL);
+    }
+
+    double elapsed = seconds() - start;
+    uint64_t tested = s.tested;
+    fprintf(stderr, "%lu keys found, %lu keys tested in %.2f s, %.3g keys/s\n", s.found,
+            tested, elapsed, tested / elapsed);
+
+    return s.found > 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/**
+princev2simd.c
+
+SSSE3, AVX2 and AVX-512BW implementations of PRINCEv2
+
+The S-layer is a pshufb lookup of the low and the high nibbles of every
+byte, SR is a byte shuffle of the high and the low nibbles, and M' is a
+masked XOR of 16-bit rotations of every column. The kernel itself is in
+princev2simdkernel.h and is compiled once for each instruction set with
+the matching target options, so this file builds without -m flags.
+**/
+
+#include <assert.h>
+#include <string.h>
+
+#include "princev2simd.h"
+#include "princev2.h"
+#include "block.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/* bytes in the widest register, the tables repeat every 16 bytes */
+enum {SIMD_TABLE_SIZE = 64};
+
+/* [0] maps low nibbles, [1] maps high nibbles */
+static uint8_t prince_simd_sbox[2][SIMD_TABLE_SIZE] __attribute__((aligned(64)));
+static uint8_t prince_simd_sbox_inverse[2][SIMD_TABLE_SIZE] __attribute__((aligned(64)));
+
+/* [0] moves high nibbles, [1] moves low nibbles */
+static uint8_t prince_simd_shift[2][SIMD_TABLE_SIZE] __attribute__((aligned(64)));
+static uint8_t prince_simd_shift_inverse[2][SIMD_TABLE_SIZE] __attribute__((aligned(64)));
+
+static void prince_simd_shuffle(const char shift[NUM_OF_NIBBLES],
+                                uint8_t table[2][SIMD_TABLE_SIZE]) {
+    for (int i = 0; i < SIMD_TABLE_SIZE; i++) {
+        int lane = i & ~7;
+        int nibble = 2 * (7 - (i & 7));
+
+        table[0][i] = lane + 7 - shift[nibble] / 2;
+        table[1][i] = lane + 7 - shift[nibble + 1] / 2;
+    }
+}
+
+/* builds the shuffle tables from the reference S-boxes and permutations */
+__attribute__((constructor(101)))
+static void prince_simd_init(void) {
+    for (int i = 0; i < SIMD_TABLE_SIZE; i++) {
+        int v = i % SBOX_SIZE;
+
+        prince_simd_sbox[0][i] = prince_sbox[v];
+        prince_simd_sbox[1][i] = prince_sbox[v] << 4;
+        prince_simd_sbox_inverse[0][i] = prince_sbox_inverse[v];
+        prince_simd_sbox_inverse[1][i] = prince_sbox_inverse[v] << 4;
+    }
+
+    prince_simd_shuffle(prince_shift, prince_simd_shift);
+    prince_simd_shuffle(prince_shift_inverse, prince_simd_shift_inverse);
+}
+
+/* SSSE3, two blocks per register */
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#define simd_t __m128i
+#define SIMD_SUFFIX ssse3
+#define SIMD_LANES 2
+#define SIMD_LOAD(p) _mm_loadu_si128((const __m128i*) (p))
+#define SIMD_STORE(p, x) _mm_storeu_si128((__m128i*) (p), (x))
+#define SIMD_SET1(w) _mm_set1_epi64x(w)
+#define SIMD_AND _mm_and_si128
+#define SIMD_ANDNOT _mm_andnot_si128
+#define SIMD_OR _mm_or_si128
+#define SIMD_XOR _mm_xor_si128
+#define SIMD_SHUFFLE _mm_shuffle_epi8
+#define SIMD_SLLI16 _mm_slli_epi16
+#define SIMD_SRLI16 _mm_srli_epi16
+#include "princev2simdkernel.h"
+#pragma GCC pop_options
+
+/* AVX2, four blocks per register */
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define simd_t __m256i
+#define SIMD_SUFFIX avx2
+#define SIMD_LANES 4
+#define SIMD_LOAD(p) _mm256_loadu_si256((const __m256i*) (p))
+#define SIMD_STORE(p, x) _mm256_storeu_si256((__m256i*) (p), (x))
+#define SIMD_SET1(w) _mm256_set1_epi64x(w)
+#define SIMD_AND _mm256_and_si256
+#define SIMD_ANDNOT _mm256_andnot_si256
+#define SIMD_OR _mm256_or_si256
+#define SIMD_XOR _mm256_xor_si256
+#define SIMD_SHUFFLE _mm256_shuffle_epi8
+#define SIMD_SLLI16 _mm256_slli_epi16
+#define SIMD_SRLI16 _mm256_srli_epi16
+#include "princev2simdkernel.h"
+#pragma GCC pop_options
+
+/* AVX-512BW, eight blocks per register */
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+#define simd_t __m512i
+#define SIMD_SUFFIX avx512
+#define SIMD_LANES 8
+#define SIMD_LOAD(p) _mm512_loadu_si512((const void*) (p))
+#define SIMD_STORE(p, x) _mm512_storeu_si512((void*) (p), (x))
+#define SIMD_SET1(w) _mm512_set1_epi64(w)
+#define SIMD_AND _mm512_and_si512
+#define SIMD_ANDNOT _mm512_andnot_si512
+#define SIMD_OR _mm512_or_si512
+#define SIMD_XOR _mm512_xor_si512
+#define SIMD_SHUFFLE _mm512_shuffle_epi8
+#define SIMD_SLLI16 _mm512_slli_epi16
+#define SIMD_SRLI16 _mm512_srli_epi16
+#include "princev2simdkernel.h"
+#pragma GCC pop_options
+
+#endif
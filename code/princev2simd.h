@@ -0,0 +1,76 @@
+/**
+princev2simd.h
+
+Interface for the SSSE3/AVX2/AVX-512 PRINCEv2 engines
+
+Every 64-bit lane of a vector register holds one block, so a register
+carries 2 (SSSE3), 4 (AVX2) or 8 (AVX-512BW) blocks. The functions do not
+check the CPU, the caller has to make sure the instruction set is there.
+**/
+
+#ifndef _PRINCE_SIMD_
+#define _PRINCE_SIMD_
+
+#include <stddef.h>
+
+#include "key.h"
+#include "princev2.h"
+
+/* encrypts/decrypts n blocks from in to out under one key.
+   in and out may be the same array and need not be aligned */
+void prince_encrypt_ssse3(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+void prince_decrypt_ssse3(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+
+void prince_encrypt_avx2(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+void prince_decrypt_avx2(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+
+void prince_encrypt_avx512(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+void prince_decrypt_avx512(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n);
+
+/* same with a key expanded by prince_ctx_init */
+void prince_encrypt_ssse3_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                              uint64_t* out, size_t n);
+void prince_decrypt_ssse3_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                              uint64_t* out, size_t n);
+
+void prince_encrypt_avx2_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                             uint64_t* out, size_t n);
+void prince_decrypt_avx2_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                             uint64_t* out, size_t n);
+
+void prince_encrypt_avx512_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                               uint64_t* out, size_t n);
+void prince_decrypt_avx512_ctx(const princev2ctx_t* ctx, const uint64_t* in,
+                               uint64_t* out, size_t n);
+
+/* one key per block, in[i] goes through keys[i] */
+void prince_encrypt_keys_ssse3(const princev2key_t* keys, const uint64_t* in,
+                               uint64_t* out, size_t n);
+void prince_decrypt_keys_ssse3(const princev2key_t* keys, const uint64_t* in,
+                               uint64_t* out, size_t n);
+
+void prince_encrypt_keys_avx2(const princev2key_t* keys, const uint64_t* in,
+                              uint64_t* out, size_t n);
+void prince_decrypt_keys_avx2(const princev2key_t* keys, const uint64_t* in,
+                              uint64_t* out, size_t n);
+
+void prince_encrypt_keys_avx512(const princev2key_t* keys, const uint64_t* in,
+                                uint64_t* out, size_t n);
+void prince_decrypt_keys_avx512(const princev2key_t* keys, const uint64_t* in,
+                                uint64_t* out, size_t n);
+
+/* reduced-round encryption under the key list rk, see prince_core_rounds.
+   Every number of forward and of backward rounds has its own unrolled part,
+   picked from a table by forward and backward and called around the middle
+   layer, which only runs if middle is set */
+void prince_encrypt_rounds_ssse3(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n);
+void prince_encrypt_rounds_avx2(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                int forward, int middle, int backward,
+                                const uint64_t* in, uint64_t* out, size_t n);
+void prince_encrypt_rounds_avx512(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                  int forward, int middle, int backward,
+                                  const uint64_t* in, uint64_t* out, size_t n);
+
+#endif
@@ -0,0 +1,358 @@
+/**
+princev2simdkernel.h
+
+Instruction set independent PRINCEv2 kernel, included by princev2simd.c
+once per instruction set. The includer defines simd_t, SIMD_SUFFIX,
+SIMD_LANES and the SIMD_* operations below; they are undefined again at
+the end of this file.
+
+Every 64-bit lane holds one block in native byte order, so nibble i
+(i = 0 is the most significant one) is in byte 7 - i/2 of its lane.
+**/
+
+#define SIMD_CONCAT_(name, suffix) name ## _ ## suffix
+#define SIMD_CONCAT(name, suffix) SIMD_CONCAT_(name, suffix)
+#define SIMD_FN(name) SIMD_CONCAT(name, SIMD_SUFFIX)
+#define SIMD_CTX_FN(name) SIMD_CONCAT(SIMD_FN(name), ctx)
+
+/* interleaved registers per iteration to hide the latency of a round */
+#define SIMD_INTERLEAVE 2
+#define SIMD_BATCH (SIMD_INTERLEAVE * SIMD_LANES)
+
+typedef struct {
+    simd_t nibble;
+    simd_t sbox[2];
+    simd_t sbox_inverse[2];
+    simd_t shift[2];
+    simd_t shift_inverse[2];
+    simd_t mask[4];
+    simd_t keys[1][NUM_OF_KEY_ADDITIONS];
+} SIMD_FN(prince_simd_consts_t);
+
+/* the parts below add keys[j * step][k] to register j: step 0 shares one
+   key list, step 1 gives every register its own (multi-key batches) */
+typedef simd_t SIMD_FN(prince_simd_keys_t)[NUM_OF_KEY_ADDITIONS];
+
+/* both nibbles of every byte go through a 16-entry byte shuffle */
+static inline simd_t SIMD_FN(prince_simd_s_layer)(simd_t x, const simd_t sbox[2],
+                                                  simd_t nibble) {
+    simd_t lo = SIMD_AND(x, nibble);
+    simd_t hi = SIMD_AND(SIMD_SRLI16(x, 4), nibble);
+
+    return SIMD_OR(SIMD_SHUFFLE(sbox[0], lo), SIMD_SHUFFLE(sbox[1], hi));
+}
+
+/* SR and SR^-1 keep nibbles at even/odd positions even/odd, so the high
+   and low nibbles are moved by one byte shuffle each */
+static inline simd_t SIMD_FN(prince_simd_permute)(simd_t x, const simd_t shift[2],
+                                                  simd_t nibble) {
+    simd_t hi = SIMD_ANDNOT(nibble, x);
+    simd_t lo = SIMD_AND(x, nibble);
+
+    return SIMD_OR(SIMD_SHUFFLE(hi, shift[0]), SIMD_SHUFFLE(lo, shift[1]));
+}
+
+/* M' on every 16-bit column: XOR of the column rotated by 0, 4, 8 and 12
+   bits, each masked with the matching diagonal entries of MHat0/MHat1
+   (prince_m_mask, the same as the word level prince_m_layer) */
+static inline simd_t SIMD_FN(prince_simd_m_layer)(simd_t x, const simd_t mask[4]) {
+    simd_t r4  = SIMD_OR(SIMD_SLLI16(x, 4),  SIMD_SRLI16(x, 12));
+    simd_t r8  = SIMD_OR(SIMD_SLLI16(x, 8),  SIMD_SRLI16(x, 8));
+    simd_t r12 = SIMD_OR(SIMD_SLLI16(x, 12), SIMD_SRLI16(x, 4));
+
+    return SIMD_XOR(SIMD_XOR(SIMD_AND(x, mask[0]), SIMD_AND(r4, mask[1])),
+                    SIMD_XOR(SIMD_AND(r8, mask[2]), SIMD_AND(r12, mask[3])));
+}
+
+/* the rounds of prince_core up to the middle layer: the whitening and
+   forward rounds 1..forward. Called with a constant the loop is unrolled */
+static inline __attribute__((always_inline))
+void SIMD_FN(prince_simd_forward)(const SIMD_FN(prince_simd_consts_t)* c,
+                                  simd_t x[SIMD_INTERLEAVE], const int forward,
+                                  const SIMD_FN(prince_simd_keys_t)* keys, const int step) {
+    for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+        x[j] = SIMD_XOR(x[j], keys[j * step][0]);
+    }
+
+#pragma GCC unroll 8
+    for (int i = 1; i <= forward; i++) {
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            x[j] = SIMD_FN(prince_simd_s_layer)(x[j], c->sbox, c->nibble);
+            x[j] = SIMD_FN(prince_simd_m_layer)(x[j], c->mask);
+            x[j] = SIMD_FN(prince_simd_permute)(x[j], c->shift, c->nibble);
+            x[j] = SIMD_XOR(x[j], keys[j * step][i]);
+        }
+    }
+}
+
+static inline __attribute__((always_inline))
+void SIMD_FN(prince_simd_middle)(const SIMD_FN(prince_simd_consts_t)* c,
+                                 simd_t x[SIMD_INTERLEAVE],
+                                 const SIMD_FN(prince_simd_keys_t)* keys, const int step) {
+    for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+        x[j] = SIMD_FN(prince_simd_s_layer)(x[j], c->sbox, c->nibble);
+        x[j] = SIMD_XOR(x[j], keys[j * step][NUM_OF_ROUNDS / 2]);
+        x[j] = SIMD_FN(prince_simd_m_layer)(x[j], c->mask);
+        x[j] = SIMD_XOR(x[j], keys[j * step][NUM_OF_ROUNDS / 2 + 1]);
+        x[j] = SIMD_FN(prince_simd_s_layer)(x[j], c->sbox_inverse, c->nibble);
+    }
+}
+
+/* the rounds after the middle layer: inverse rounds 11 - backward..10 and
+   the final whitening. Inverse round i of prince_core adds key i + 2 */
+static inline __attribute__((always_inline))
+void SIMD_FN(prince_simd_backward)(const SIMD_FN(prince_simd_consts_t)* c,
+                                   simd_t x[SIMD_INTERLEAVE], const int backward,
+                                   const SIMD_FN(prince_simd_keys_t)* keys, const int step) {
+#pragma GCC unroll 8
+    for (int i = NUM_OF_ROUNDS - 1 - backward; i < NUM_OF_ROUNDS - 1; i++) {
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            x[j] = SIMD_XOR(x[j], keys[j * step][i + 2]);
+            x[j] = SIMD_FN(prince_simd_permute)(x[j], c->shift_inverse, c->nibble);
+            x[j] = SIMD_FN(prince_simd_m_layer)(x[j], c->mask);
+            x[j] = SIMD_FN(prince_simd_s_layer)(x[j], c->sbox_inverse, c->nibble);
+        }
+    }
+
+    for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+        x[j] = SIMD_XOR(x[j], keys[j * step][NUM_OF_KEY_ADDITIONS - 1]);
+    }
+}
+
+typedef void (*SIMD_FN(prince_simd_part_t))(const SIMD_FN(prince_simd_consts_t)* c,
+                                            simd_t x[SIMD_INTERLEAVE]);
+
+/* one unrolled forward and backward part per round count 0..5, so any
+   reduced-round core is two calls and maybe the middle layer */
+#define SIMD_ROUNDS_EACH(X) X(0) X(1) X(2) X(3) X(4) X(5)
+
+#define SIMD_ROUNDS_DEFINE(r) \
+    static void SIMD_FN(prince_simd_forward_ ## r)(const SIMD_FN(prince_simd_consts_t)* c, \
+                                                   simd_t x[SIMD_INTERLEAVE]) { \
+        SIMD_FN(prince_simd_forward)(c, x, r, c->keys, 0); \
+    } \
+    static void SIMD_FN(prince_simd_backward_ ## r)(const SIMD_FN(prince_simd_consts_t)* c, \
+                                                    simd_t x[SIMD_INTERLEAVE]) { \
+        SIMD_FN(prince_simd_backward)(c, x, r, c->keys, 0); \
+    }
+#define SIMD_ROUNDS_FORWARD(r) SIMD_FN(prince_simd_forward_ ## r),
+#define SIMD_ROUNDS_BACKWARD(r) SIMD_FN(prince_simd_backward_ ## r),
+
+SIMD_ROUNDS_EACH(SIMD_ROUNDS_DEFINE)
+
+static const SIMD_FN(prince_simd_part_t) SIMD_FN(prince_simd_forwards)[] = {
+    SIMD_ROUNDS_EACH(SIMD_ROUNDS_FORWARD)
+};
+
+static const SIMD_FN(prince_simd_part_t) SIMD_FN(prince_simd_backwards)[] = {
+    SIMD_ROUNDS_EACH(SIMD_ROUNDS_BACKWARD)
+};
+
+static void SIMD_FN(prince_simd_consts)(SIMD_FN(prince_simd_consts_t)* c,
+                                        const uint64_t rk[NUM_OF_KEY_ADDITIONS]) {
+    c->nibble = SIMD_SET1(0x0f0f0f0f0f0f0f0f);
+    c->sbox[0] = SIMD_LOAD(prince_simd_sbox[0]);
+    c->sbox[1] = SIMD_LOAD(prince_simd_sbox[1]);
+    c->sbox_inverse[0] = SIMD_LOAD(prince_simd_sbox_inverse[0]);
+    c->sbox_inverse[1] = SIMD_LOAD(prince_simd_sbox_inverse[1]);
+    c->shift[0] = SIMD_LOAD(prince_simd_shift[0]);
+    c->shift[1] = SIMD_LOAD(prince_simd_shift[1]);
+    c->shift_inverse[0] = SIMD_LOAD(prince_simd_shift_inverse[0]);
+    c->shift_inverse[1] = SIMD_LOAD(prince_simd_shift_inverse[1]);
+    for (int d = 0; d < 4; d++) {
+        c->mask[d] = SIMD_SET1(prince_m_mask[d]);
+    }
+
+    for (int k = 0; k < NUM_OF_KEY_ADDITIONS; k++) {
+        c->keys[0][k] = SIMD_SET1(rk[k]);
+    }
+}
+
+/* runs forward, the middle layer if middle is set, and backward over n
+   blocks. With constant arguments the calls are inlined */
+static inline __attribute__((always_inline))
+void SIMD_FN(prince_simd_run)(const SIMD_FN(prince_simd_consts_t)* c,
+                              SIMD_FN(prince_simd_part_t) forward, int middle,
+                              SIMD_FN(prince_simd_part_t) backward,
+                              const uint64_t* in, uint64_t* out, size_t n) {
+    simd_t x[SIMD_INTERLEAVE];
+
+    for (; n >= SIMD_BATCH; n -= SIMD_BATCH, in += SIMD_BATCH, out += SIMD_BATCH) {
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            x[j] = SIMD_LOAD(in + j * SIMD_LANES);
+        }
+
+        forward(c, x);
+        if (middle) {
+            SIMD_FN(prince_simd_middle)(c, x, c->keys, 0);
+        }
+        backward(c, x);
+
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            SIMD_STORE(out + j * SIMD_LANES, x[j]);
+        }
+    }
+
+    /* the remaining blocks are zero padded to a full batch */
+    if (n > 0) {
+        uint64_t buffer[SIMD_BATCH] = {0};
+        memcpy(buffer, in, n * sizeof(uint64_t));
+
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            x[j] = SIMD_LOAD(buffer + j * SIMD_LANES);
+        }
+
+        forward(c, x);
+        if (middle) {
+            SIMD_FN(prince_simd_middle)(c, x, c->keys, 0);
+        }
+        backward(c, x);
+
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            SIMD_STORE(buffer + j * SIMD_LANES, x[j]);
+        }
+        memcpy(out, buffer, n * sizeof(uint64_t));
+    }
+}
+
+static void SIMD_FN(prince_simd_blocks)(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                        const uint64_t* in, uint64_t* out, size_t n) {
+    SIMD_FN(prince_simd_consts_t) c;
+
+    SIMD_FN(prince_simd_consts)(&c, rk);
+    SIMD_FN(prince_simd_run)(&c, SIMD_FN(prince_simd_forward_5), 1,
+                             SIMD_FN(prince_simd_backward_5), in, out, n);
+}
+
+void SIMD_FN(prince_encrypt)(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+
+    prince_roundKeys(key, ENC, rk);
+    SIMD_FN(prince_simd_blocks)(rk, in, out, n);
+}
+
+void SIMD_FN(prince_decrypt)(princev2key_t key, const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+
+    prince_roundKeys(key_new(key.k1^BETA, key.k0^ALPHA), DEC, rk);
+    SIMD_FN(prince_simd_blocks)(rk, in, out, n);
+}
+
+void SIMD_CTX_FN(prince_encrypt)(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n) {
+    SIMD_FN(prince_simd_blocks)(ctx->enc, in, out, n);
+}
+
+void SIMD_CTX_FN(prince_decrypt)(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n) {
+    SIMD_FN(prince_simd_blocks)(ctx->dec, in, out, n);
+}
+
+void SIMD_FN(prince_encrypt_rounds)(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                    int forward, int middle, int backward,
+                                    const uint64_t* in, uint64_t* out, size_t n) {
+    SIMD_FN(prince_simd_consts_t) c;
+
+    assert(forward >= 0 && forward <= NUM_OF_FORWARD_ROUNDS);
+    assert(backward >= 0 && backward <= NUM_OF_INVERSE_ROUNDS);
+
+    SIMD_FN(prince_simd_consts)(&c, rk);
+    SIMD_FN(prince_simd_run)(&c, SIMD_FN(prince_simd_forwards)[forward], middle,
+                             SIMD_FN(prince_simd_backwards)[backward], in, out, n);
+}
+
+/* one key per lane: the key words of every batch are gathered into
+   vectors, and the round keys are those words XOR the constants in c */
+static void SIMD_FN(prince_simd_keys)(princemode_t mode, const princev2key_t* keys,
+                                      const uint64_t* in, uint64_t* out, size_t n) {
+    SIMD_FN(prince_simd_consts_t) c;
+    SIMD_FN(prince_simd_keys_t) rk[SIMD_INTERLEAVE];
+    uint64_t constant[NUM_OF_KEY_ADDITIONS];
+    int word[NUM_OF_KEY_ADDITIONS];
+    uint64_t words[2][SIMD_BATCH];
+    uint64_t buffer[SIMD_BATCH];
+    simd_t x[SIMD_INTERLEAVE];
+
+    prince_roundKeyWords(mode, constant, word);
+    SIMD_FN(prince_simd_consts)(&c, constant);
+
+    while (n > 0) {
+        size_t count = n < SIMD_BATCH ? n : SIMD_BATCH;
+
+        /* a partial batch goes through buffer, its unused lanes are zero */
+        const uint64_t* src = in;
+        uint64_t* dst = out;
+        if (count < SIMD_BATCH) {
+            memset(words, 0, sizeof(words));
+            memset(buffer, 0, sizeof(buffer));
+            memcpy(buffer, in, count * sizeof(uint64_t));
+            src = dst = buffer;
+        }
+        for (size_t i = 0; i < count; i++) {
+            words[0][i] = keys[i].k0;
+            words[1][i] = keys[i].k1;
+        }
+
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            simd_t k0 = SIMD_LOAD(words[0] + j * SIMD_LANES);
+            simd_t k1 = SIMD_LOAD(words[1] + j * SIMD_LANES);
+
+            for (int k = 0; k < NUM_OF_KEY_ADDITIONS; k++) {
+                rk[j][k] = SIMD_XOR(word[k] ? k1 : k0, c.keys[0][k]);
+            }
+            x[j] = SIMD_LOAD(src + j * SIMD_LANES);
+        }
+
+        SIMD_FN(prince_simd_forward)(&c, x, NUM_OF_FORWARD_ROUNDS, rk, 1);
+        SIMD_FN(prince_simd_middle)(&c, x, rk, 1);
+        SIMD_FN(prince_simd_backward)(&c, x, NUM_OF_INVERSE_ROUNDS, rk, 1);
+
+        for (int j = 0; j < SIMD_INTERLEAVE; j++) {
+            SIMD_STORE(dst + j * SIMD_LANES, x[j]);
+        }
+        if (dst != out) {
+            memcpy(out, buffer, count * sizeof(uint64_t));
+        }
+
+        keys += count;
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
+
+void SIMD_FN(prince_encrypt_keys)(const princev2key_t* keys, const uint64_t* in,
+                                  uint64_t* out, size_t n) {
+    SIMD_FN(prince_simd_keys)(ENC, keys, in, out, n);
+}
+
+void SIMD_FN(prince_decrypt_keys)(const princev2key_t* keys, const uint64_t* in,
+                                  uint64_t* out, size_t n) {
+    SIMD_FN(prince_simd_keys)(DEC, keys, in, out, n);
+}
+
+#undef SIMD_ROUNDS_EACH
+#undef SIMD_ROUNDS_DEFINE
+#undef SIMD_ROUNDS_FORWARD
+#undef SIMD_ROUNDS_BACKWARD
+
+#undef SIMD_BATCH
+#undef SIMD_INTERLEAVE
+#undef SIMD_FN
+#undef SIMD_CONCAT
+#undef SIMD_CONCAT_
+#undef SIMD_CTX_FN
+
+#undef simd_t
+#undef SIMD_SUFFIX
+#undef SIMD_LANES
+#undef SIMD_LOAD
+#undef SIMD_STORE
+#undef SIMD_SET1
+#undef SIMD_AND
+#undef SIMD_ANDNOT
+#undef SIMD_OR
+#undef SIMD_XOR
+#undef SIMD_SHUFFLE
+#undef SIMD_SLLI16
+#undef SIMD_SRLI16
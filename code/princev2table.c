@@ -0,0 +1,363 @@
+/**
+princev2table.c
+
+Table-driven implementation of PRINCEv2
+
+A forward round SR(M'(S(x))) is linear after the S-layer, so it can be
+written as the XOR of eight lookups, one per input byte:
+
+   T_fwd[j][v] = SR(M'(S(v) placed at byte j))
+
+An inverse round S^-1(M'(SR^-1(x))) has the S-layer at the end, so the
+inverse half is re-associated: the S^-1 of one round is merged with the
+M'(SR^-1(.)) of the next round,
+
+   T_inv[j][v] = M'(SR^-1(S^-1(v) placed at byte j))
+
+and the round key is pushed through the linear layer L = M' o SR^-1, which
+only has to be done once per call for k0 and k1 (the round constants are
+folded in when the tables are built). The last S^-1 and the middle S and M'
+layers use a byte-wise S-box and nibble-wise linear tables respectively.
+
+All tables are derived from the reference layers in princev2.c, so this
+engine produces exactly the same output as prince_core.
+**/
+
+#include <assert.h>
+#include <string.h>
+
+#include "princev2table.h"
+#include "block.h"
+
+/* independent blocks in flight in prince_table_blocks */
+enum {TABLE_INTERLEAVE = 4};
+
+static uint64_t prince_table_fwd[NUM_OF_BYTES][BYTE_TABLE_SIZE];
+static uint64_t prince_table_inv[NUM_OF_BYTES][BYTE_TABLE_SIZE];
+
+/* S-box and inverse S-box applied to both nibbles of a byte */
+static uint8_t prince_table_sbox[BYTE_TABLE_SIZE];
+static uint8_t prince_table_sbox_inverse[BYTE_TABLE_SIZE];
+
+/* M' and L = M' o SR^-1 for a single nibble at (least significant first)
+   position n, used for the key dependent linear terms */
+static uint64_t prince_table_m[NUM_OF_NIBBLES][SBOX_SIZE];
+static uint64_t prince_table_l[NUM_OF_NIBBLES][SBOX_SIZE];
+
+/* L(RC[i]) for the inverse rounds */
+static uint64_t prince_table_lrc[NUM_OF_ROUNDS];
+
+static uint64_t prince_table_l_ref(uint64_t state) {
+    return prince_m_layer(prince_shiftRowInverse(state));
+}
+
+/* builds all tables from the reference layers, runs before main */
+__attribute__((constructor(101)))
+static void prince_table_init(void) {
+    for (int v = 0; v < BYTE_TABLE_SIZE; v++) {
+        prince_table_sbox[v] = (prince_sbox[v >> 4] << 4) | prince_sbox[v & 0xf];
+        prince_table_sbox_inverse[v] =
+            (prince_sbox_inverse[v >> 4] << 4) | prince_sbox_inverse[v & 0xf];
+    }
+
+    for (int j = 0; j < NUM_OF_BYTES; j++) {
+        for (int v = 0; v < BYTE_TABLE_SIZE; v++) {
+            uint64_t s = (uint64_t) prince_table_sbox[v] << (8*j);
+            uint64_t si = (uint64_t) prince_table_sbox_inverse[v] << (8*j);
+
+            prince_table_fwd[j][v] = prince_shiftRow(prince_m_layer(s));
+            prince_table_inv[j][v] = prince_table_l_ref(si);
+        }
+    }
+
+    for (int n = 0; n < NUM_OF_NIBBLES; n++) {
+        for (int v = 0; v < SBOX_SIZE; v++) {
+            uint64_t x = (uint64_t) v << (4*n);
+
+            prince_table_m[n][v] = prince_m_layer(x);
+            prince_table_l[n][v] = prince_table_l_ref(x);
+        }
+    }
+
+    for (int i = 0; i < NUM_OF_ROUNDS - 1; i++) {
+        prince_table_lrc[i] = prince_table_l_ref(RCs[i]);
+    }
+}
+
+static inline uint64_t prince_table_round(const uint64_t t[NUM_OF_BYTES][BYTE_TABLE_SIZE],
+                                          uint64_t x) {
+    return t[0][x         & 0xff] ^ t[1][(x >>  8) & 0xff] ^
+           t[2][(x >> 16) & 0xff] ^ t[3][(x >> 24) & 0xff] ^
+           t[4][(x >> 32) & 0xff] ^ t[5][(x >> 40) & 0xff] ^
+           t[6][(x >> 48) & 0xff] ^ t[7][(x >> 56)       ];
+}
+
+static inline uint64_t prince_table_bytes(const uint8_t t[BYTE_TABLE_SIZE], uint64_t x) {
+    uint64_t y = 0;
+
+    for (int j = 0; j < NUM_OF_BYTES; j++) {
+        y |= (uint64_t) t[(x >> (8*j)) & 0xff] << (8*j);
+    }
+
+    return y;
+}
+
+static inline uint64_t prince_table_linear(const uint64_t t[NUM_OF_NIBBLES][SBOX_SIZE],
+                                           uint64_t x) {
+    uint64_t y = 0;
+
+    for (int n = 0; n < NUM_OF_NIBBLES; n++) {
+        y ^= t[n][(x >> (4*n)) & 0xf];
+    }
+
+    return y;
+}
+
+uint64_t prince_core_table(princev2key_t key, uint64_t state, princemode_t mode) {
+    uint64_t rkeys[] = {key.k0, key.k1};
+    state ^= rkeys[0];
+
+    for (int i = 1; i < NUM_OF_ROUNDS / 2; i++) {
+        state = prince_table_round(prince_table_fwd, state) ^ RCs[i] ^ rkeys[i % 2];
+    }
+
+    state = prince_table_bytes(prince_table_sbox, state);
+    state = prince_table_linear(prince_table_m, state ^ rkeys[0]);
+
+    if (mode == DEC) {
+        rkeys[0] ^= ALPHA ^ BETA;
+        rkeys[1] ^= ALPHA ^ BETA;
+    }
+
+    state ^= rkeys[1] ^ BETA;
+
+    uint64_t lkeys[] = {
+        prince_table_linear(prince_table_l, rkeys[0]),
+        prince_table_linear(prince_table_l, rkeys[1]),
+    };
+
+    for (int i = NUM_OF_ROUNDS / 2; i < NUM_OF_ROUNDS - 1; i++) {
+        state = prince_table_round(prince_table_inv, state) ^ prince_table_lrc[i] ^ lkeys[i % 2];
+    }
+
+    state = prince_table_bytes(prince_table_sbox_inverse, state);
+    state ^= rkeys[1] ^ BETA;
+
+    return state;
+}
+
+uint64_t prince_encrypt_table(princev2key_t key, uint64_t plaintext) {
+    return prince_core_table(key, plaintext, ENC);
+}
+
+uint64_t prince_decrypt_table(princev2key_t key, uint64_t ciphertext) {
+    return prince_core_table(key_new(key.k1^BETA, key.k0^ALPHA), ciphertext, DEC);
+}
+
+static uint64_t prince_core_tableCtx(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                     const uint64_t linear[NUM_OF_INVERSE_ROUNDS],
+                                     uint64_t state) {
+    int k = 0;
+    state ^= rk[k++];
+
+    for (int i = 1; i < NUM_OF_ROUNDS / 2; i++) {
+        state = prince_table_round(prince_table_fwd, state) ^ rk[k++];
+    }
+
+    state = prince_table_bytes(prince_table_sbox, state);
+    state = prince_table_linear(prince_table_m, state ^ rk[k]) ^ rk[k + 1];
+
+    for (int i = 0; i < NUM_OF_INVERSE_ROUNDS; i++) {
+        state = prince_table_round(prince_table_inv, state) ^ linear[i];
+    }
+
+    state = prince_table_bytes(prince_table_sbox_inverse, state);
+    state ^= rk[NUM_OF_KEY_ADDITIONS - 1];
+
+    return state;
+}
+
+uint64_t prince_encrypt_table_ctx(const princev2ctx_t* ctx, uint64_t plaintext) {
+    return prince_core_tableCtx(ctx->enc, ctx->encLinear, plaintext);
+}
+
+uint64_t prince_decrypt_table_ctx(const princev2ctx_t* ctx, uint64_t ciphertext) {
+    return prince_core_tableCtx(ctx->dec, ctx->decLinear, ciphertext);
+}
+
+/* prince_core_tableCtx on TABLE_INTERLEAVE blocks at once, so the lookups of
+   one block overlap with the dependency chain of the others */
+static void prince_table_blocks(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                const uint64_t linear[NUM_OF_INVERSE_ROUNDS],
+                                const uint64_t* in, uint64_t* out, size_t n) {
+    uint64_t state[TABLE_INTERLEAVE];
+
+    for (; n >= TABLE_INTERLEAVE; n -= TABLE_INTERLEAVE, in += TABLE_INTERLEAVE,
+                                  out += TABLE_INTERLEAVE) {
+        for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+            state[j] = in[j] ^ rk[0];
+        }
+
+        for (int i = 1; i < NUM_OF_ROUNDS / 2; i++) {
+            for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+                state[j] = prince_table_round(prince_table_fwd, state[j]) ^ rk[i];
+            }
+        }
+
+        for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+            state[j] = prince_table_bytes(prince_table_sbox, state[j]);
+            state[j] = prince_table_linear(prince_table_m, state[j] ^ rk[NUM_OF_ROUNDS / 2])
+                       ^ rk[NUM_OF_ROUNDS / 2 + 1];
+        }
+
+        for (int i = 0; i < NUM_OF_INVERSE_ROUNDS; i++) {
+            for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+                state[j] = prince_table_round(prince_table_inv, state[j]) ^ linear[i];
+            }
+        }
+
+        for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+            state[j] = prince_table_bytes(prince_table_sbox_inverse, state[j]);
+            out[j] = state[j] ^ rk[NUM_OF_KEY_ADDITIONS - 1];
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prince_core_tableCtx(rk, linear, in[i]);
+    }
+}
+
+void prince_encrypt_table_blocks(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n) {
+    prince_table_blocks(ctx->enc, ctx->encLinear, in, out, n);
+}
+
+void prince_decrypt_table_blocks(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n) {
+    prince_table_blocks(ctx->dec, ctx->decLinear, in, out, n);
+}
+
+/* reduced rounds, see prince_core_rounds. The parts below keep the state
+   of TABLE_INTERLEAVE blocks; the backward part expects it before the
+   S^-1 of the layer in front of it, so without the middle layer the state
+   goes through S first and the S^-1 of the first inverse round undoes it */
+typedef struct {
+    const uint64_t* rk;
+    /* L(rk[k]) for the keys of the inverse rounds */
+    uint64_t linear[NUM_OF_KEY_ADDITIONS];
+} tablerounds_t;
+
+/* the whitening and forward rounds 1..forward. Called with a constant the
+   loop is unrolled */
+static inline __attribute__((always_inline))
+void prince_table_forward(const tablerounds_t* c, uint64_t state[TABLE_INTERLEAVE],
+                          const int forward) {
+    for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+        state[j] ^= c->rk[0];
+    }
+
+#pragma GCC unroll 8
+    for (int i = 1; i <= forward; i++) {
+        for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+            state[j] = prince_table_round(prince_table_fwd, state[j]) ^ c->rk[i];
+        }
+    }
+}
+
+static inline __attribute__((always_inline))
+void prince_table_middle(const tablerounds_t* c, uint64_t state[TABLE_INTERLEAVE],
+                         const int middle) {
+    for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+        state[j] = prince_table_bytes(prince_table_sbox, state[j]);
+        if (middle) {
+            state[j] = prince_table_linear(prince_table_m, state[j] ^ c->rk[NUM_OF_ROUNDS / 2])
+                       ^ c->rk[NUM_OF_ROUNDS / 2 + 1];
+        }
+    }
+}
+
+/* inverse rounds 11 - backward..10 and the final whitening. Inverse round i
+   of prince_core adds key i + 2 */
+static inline __attribute__((always_inline))
+void prince_table_backward(const tablerounds_t* c, uint64_t state[TABLE_INTERLEAVE],
+                           const int backward) {
+#pragma GCC unroll 8
+    for (int i = NUM_OF_ROUNDS - 1 - backward; i < NUM_OF_ROUNDS - 1; i++) {
+        for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+            state[j] = prince_table_round(prince_table_inv, state[j]) ^ c->linear[i + 2];
+        }
+    }
+
+    for (int j = 0; j < TABLE_INTERLEAVE; j++) {
+        state[j] = prince_table_bytes(prince_table_sbox_inverse, state[j]);
+        state[j] ^= c->rk[NUM_OF_KEY_ADDITIONS - 1];
+    }
+}
+
+typedef void (*tablepart_t)(const tablerounds_t* c, uint64_t state[TABLE_INTERLEAVE]);
+
+/* one unrolled forward and backward part per round count 0..5 */
+#define TABLE_ROUNDS_EACH(X) X(0) X(1) X(2) X(3) X(4) X(5)
+
+#define TABLE_ROUNDS_DEFINE(r) \
+    static void prince_table_forward_ ## r(const tablerounds_t* c, \
+                                           uint64_t state[TABLE_INTERLEAVE]) { \
+        prince_table_forward(c, state, r); \
+    } \
+    static void prince_table_backward_ ## r(const tablerounds_t* c, \
+                                            uint64_t state[TABLE_INTERLEAVE]) { \
+        prince_table_backward(c, state, r); \
+    }
+#define TABLE_ROUNDS_FORWARD(r) prince_table_forward_ ## r,
+#define TABLE_ROUNDS_BACKWARD(r) prince_table_backward_ ## r,
+
+TABLE_ROUNDS_EACH(TABLE_ROUNDS_DEFINE)
+
+static const tablepart_t prince_table_forwards[] = {
+    TABLE_ROUNDS_EACH(TABLE_ROUNDS_FORWARD)
+};
+
+static const tablepart_t prince_table_backwards[] = {
+    TABLE_ROUNDS_EACH(TABLE_ROUNDS_BACKWARD)
+};
+
+#undef TABLE_ROUNDS_EACH
+#undef TABLE_ROUNDS_DEFINE
+#undef TABLE_ROUNDS_FORWARD
+#undef TABLE_ROUNDS_BACKWARD
+
+void prince_encrypt_table_rounds(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n) {
+    tablerounds_t c;
+    uint64_t state[TABLE_INTERLEAVE];
+
+    assert(forward >= 0 && forward <= NUM_OF_FORWARD_ROUNDS);
+    assert(backward >= 0 && backward <= NUM_OF_INVERSE_ROUNDS);
+
+    c.rk = rk;
+    for (int k = NUM_OF_ROUNDS / 2 + 2; k < NUM_OF_KEY_ADDITIONS - 1; k++) {
+        c.linear[k] = prince_table_linear(prince_table_l, rk[k]);
+    }
+
+    tablepart_t forwardPart = prince_table_forwards[forward];
+    tablepart_t backwardPart = prince_table_backwards[backward];
+
+    while (n > 0) {
+        size_t count = n < TABLE_INTERLEAVE ? n : TABLE_INTERLEAVE;
+
+        /* the unused blocks of a partial batch are zero */
+        memset(state, 0, sizeof(state));
+        memcpy(state, in, count * sizeof(uint64_t));
+
+        forwardPart(&c, state);
+        prince_table_middle(&c, state, middle);
+        backwardPart(&c, state);
+
+        memcpy(out, state, count * sizeof(uint64_t));
+
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
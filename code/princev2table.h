@@ -0,0 +1,41 @@
+/**
+princev2table.h
+
+Interface for the table-driven PRINCEv2 round engine
+**/
+
+#ifndef _PRINCE_TABLE_
+#define _PRINCE_TABLE_
+
+#include <stddef.h>
+
+#include "key.h"
+#include "princev2.h"
+
+/* number of bytes in a 64-bit state, each indexes its own lookup table */
+enum {NUM_OF_BYTES = 8};
+enum {BYTE_TABLE_SIZE = 256};
+
+/* same as prince_core, but every round is eight table lookups and XORs */
+uint64_t prince_core_table(princev2key_t key, uint64_t state, princemode_t mode);
+uint64_t prince_encrypt_table(princev2key_t key, uint64_t plaintext);
+uint64_t prince_decrypt_table(princev2key_t key, uint64_t ciphertext);
+
+/* same with a key expanded by prince_ctx_init, no key arithmetic per block */
+uint64_t prince_encrypt_table_ctx(const princev2ctx_t* ctx, uint64_t plaintext);
+uint64_t prince_decrypt_table_ctx(const princev2ctx_t* ctx, uint64_t ciphertext);
+
+/* encrypts/decrypts n blocks from in to out, several blocks interleaved.
+   in and out may be the same array */
+void prince_encrypt_table_blocks(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n);
+void prince_decrypt_table_blocks(const princev2ctx_t* ctx, const uint64_t* in,
+                                 uint64_t* out, size_t n);
+
+/* prince_core_rounds on n blocks under the key list rk, with an unrolled
+   part for every number of forward and of backward rounds */
+void prince_encrypt_table_rounds(const uint64_t rk[NUM_OF_KEY_ADDITIONS],
+                                 int forward, int middle, int backward,
+                                 const uint64_t* in, uint64_t* out, size_t n);
+
+#endif
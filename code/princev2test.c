@@ -5,6 +5,11 @@ This program generates N random plaintext and finds the the corresponding
 ciphertext. The key can either be random (different key for all N plaintexts)
 or fixed (same key for all N plaintext)
 
+Before that it checks the optimized code against the straightforward one
+on inputs from a fixed seed, and PRINCE (v1) and the modes against known
+answers, and exits with an error naming the first input that fails. The
+PRINCE (v1) vectors of the paper are printed after the PRINCEv2 ones.
+
 Sample Usage:
 
 Random Keys:
@@ -13,24 +18,974 @@ Random Keys:
 Fixed Key
 > princev2test 10 0123456789abcdef 0123456789abcdef 0123456789abcdef
 
+Reproducible bulk generation of N vectors from a seed, on all cores:
+> princev2test --generate 1000000000 42 [k0 k1] [--threads T] [--binary] [--output file]
+
+Every chunk of GENERATE_CHUNK vectors draws from its own substream, the
+stream of the seed jumped once per chunk, so the output only depends on
+N, the seed and the key. Text lines are "k0k1 plaintext ciphertext" (or
+"plaintext ciphertext" under a fixed key), binary records are the same
+64-bit words, most significant byte first.
+
 Sample build:
 > make princev2test
 **/
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
+#include <unistd.h>
 
+#include "hex.h"
 #include "key.h"
 #include "misc.h"
+#include "princev1.h"
 #include "princev2.h"
+#include "princev2ctr.h"
+#include "princev2engine.h"
+#include "princev2fast.h"
+#include "princev2pmac.h"
+#include "princev2xex.h"
+#include "princev2xts.h"
+#include "prng.h"
 
 enum{FIXED_KEY = 0, RANDOM_KEY = 1};
 
+/* test vector lines are collected in a buffer of this size before writing */
+enum{OUTPUT_BUFFER_BYTES = 1 << 16};
+enum{MAX_LINE_LENGTH = KEY_HEX_LENGTH + 1 + 3 * (HEX_DIGITS + 1)};
+
+/* test vectors per engine call */
+enum{VECTOR_CHUNK = 1024};
+
+/* writes value in hex followed by separator, returns the position after it */
+static char* putHex(char* str, uint64_t value, char separator) {
+    hex_encode64(value, str);
+    str[HEX_DIGITS] = separator;
+    return str + HEX_DIGITS + 1;
+}
+
+/* inputs of every self check and the seed they are drawn from */
+enum{CHECK_INPUTS = 1 << 16};
+enum{CHECK_SEED = 2024};
+
+/* Returns -1 after reporting which check failed for which input */
+static int checkFailed(const char* check, uint64_t input) {
+    fprintf(stderr, "princev2test: %s failed for %016lx\n", check, input);
+    return -1; /* error */
+}
+
+/* the word level M' and SR of princev2.c against the nibble by nibble ones */
+static int checkLayers(prng_t* rng) {
+    for (int i = 0; i < CHECK_INPUTS; i++) {
+        uint64_t x = prng_next(rng);
+
+        if (prince_m_layer(x) != prince_m_layer_nibbles(x)) {
+            return checkFailed("prince_m_layer", x);
+        }
+        if (prince_shiftRow(x) != prince_permuteNibbles(x, prince_shift)) {
+            return checkFailed("prince_shiftRow", x);
+        }
+        if (prince_shiftRowInverse(x) != prince_permuteNibbles(x, prince_shift_inverse)) {
+            return checkFailed("prince_shiftRowInverse", x);
+        }
+    }
+
+    return 0;
+}
+
+/* the literals and the unrolled core of princev2fast.h against key.c and
+   prince_encrypt/prince_decrypt, on the known answer keys and random ones */
+static int checkFast(prng_t* rng) {
+    const uint64_t constants[] = {
+        PRINCE_FAST_RC1, PRINCE_FAST_RC2, PRINCE_FAST_RC3, PRINCE_FAST_RC4, PRINCE_FAST_RC5,
+        PRINCE_FAST_RC6, PRINCE_FAST_RC7, PRINCE_FAST_RC8, PRINCE_FAST_RC9, PRINCE_FAST_RC10
+    };
+    const uint64_t known[][3] = { /* k0, k1, plaintext */
+        {0x0000000000000000, 0x0000000000000000, 0x0000000000000000},
+        {0xffffffffffffffff, 0x0000000000000000, 0x0000000000000000},
+        {0x0000000000000000, 0xffffffffffffffff, 0x0000000000000000},
+        {0x0000000000000000, 0x0000000000000000, 0xffffffffffffffff},
+        {0x0123456789abcdef, 0xfedcba9876543210, 0x0123456789abcdef}
+    };
+    enum{NUM_OF_CONSTANTS = sizeof(constants) / sizeof(constants[0])};
+    enum{NUM_OF_KNOWN = sizeof(known) / sizeof(known[0])};
+
+    if (PRINCE_FAST_ALPHA != ALPHA || PRINCE_FAST_BETA != BETA) {
+        return checkFailed("PRINCE_FAST_ALPHA/BETA", PRINCE_FAST_ALPHA);
+    }
+    for (int i = 0; i < NUM_OF_CONSTANTS; i++) {
+        if (constants[i] != RCs[i + 1]) {
+            return checkFailed("PRINCE_FAST_RC", constants[i]);
+        }
+    }
+
+    for (int i = 0; i < NUM_OF_KNOWN + CHECK_INPUTS; i++) {
+        princev2key_t key;
+        uint64_t p;
+
+        if (i < NUM_OF_KNOWN) {
+            key = key_new(known[i][0], known[i][1]);
+            p = known[i][2];
+        } else {
+            key = key_new(prng_next(rng), prng_next(rng));
+            p = prng_next(rng);
+        }
+
+        if (prince_encrypt_fast(key, p) != prince_encrypt(key, p)) {
+            return checkFailed("prince_encrypt_fast", p);
+        }
+        if (prince_decrypt_fast(key, p) != prince_decrypt(key, p)) {
+            return checkFailed("prince_decrypt_fast", p);
+        }
+    }
+
+    return 0;
+}
+
+enum{BLOCK_BYTES = sizeof(uint64_t)};
+
+/* long enough for the XTS and PMAC checks to run on several threads */
+enum{CHECK_BYTES = 300000};
+
+/* one sector encrypted block by block with prince_encrypt, as written in
+   princev2xts.h */
+static void xtsSector(princev2key_t dataKey, princev2key_t tweakKey, uint64_t sector,
+                      const uint8_t* in, uint8_t* out, size_t len) {
+    size_t m = len / BLOCK_BYTES, r = len % BLOCK_BYTES;
+    uint64_t t = prince_encrypt(tweakKey, sector);
+
+    for (size_t j = 0; j < m; j++) {
+        if (j > 0) {
+            t = prince_xex_double(t);
+        }
+        uint64_t block = loadBigEndian(in + j * BLOCK_BYTES) ^ t;
+        storeBigEndian(out + j * BLOCK_BYTES, prince_encrypt(dataKey, block) ^ t);
+    }
+
+    /* the tail of C_{m-1} fills up the partial block, its head moves to the end */
+    if (r > 0) {
+        uint8_t* last = out + (m - 1) * BLOCK_BYTES;
+        uint8_t stolen[BLOCK_BYTES];
+
+        memcpy(stolen, in + m * BLOCK_BYTES, r);
+        memcpy(stolen + r, last + r, BLOCK_BYTES - r);
+        memcpy(out + m * BLOCK_BYTES, last, r);
+
+        t = prince_xex_double(t);
+        storeBigEndian(last, prince_encrypt(dataKey, loadBigEndian(stolen) ^ t) ^ t);
+    }
+}
+
+/* prince_xts_encrypt_sectors/prince_xts_decrypt_sectors against xtsSector:
+   one block sectors, tails of 1 to 7 bytes, short last sectors, in place
+   and not, on one thread and several, and sectors decrypted on their own.
+   The known answers have bytes 0, 1, 2, ... as plaintext */
+static int checkXts(prng_t* rng) {
+    const size_t cases[][2] = { /* sector bytes, buffer bytes */
+        {8, 8}, {8, 24}, {9, 9}, {10, 30}, {11, 11}, {12, 36}, {13, 13}, {14, 42},
+        {15, 15}, {15, 45}, {16, 16}, {16, 57}, {512, 512}, {512, 1544}, {512, 1549},
+        {4096, CHECK_BYTES}, {4096, CHECK_BYTES - 3}
+    };
+    enum{NUM_OF_CASES = sizeof(cases) / sizeof(cases[0])};
+    const uint64_t known[][4] = { /* sector, bytes, first and last 8 bytes */
+        {0x0000000000000000, 8, 0x4747fc7218020328, 0x4747fc7218020328},
+        {0x0000000000000001, 13, 0x7eb87cd4f8f95c62, 0xf95c6251763ee8a5},
+        {0xffffffffffffffff, 16, 0x6e4898ea6cd92df9, 0xf1a1163b79348f7d}
+    };
+    enum{NUM_OF_KNOWN = sizeof(known) / sizeof(known[0])};
+    princev2key_t dataKey = key_new(0x0123456789abcdef, 0xfedcba9876543210);
+    princev2key_t tweakKey = key_new(0xfedcba9876543210, 0x0123456789abcdef);
+    uint64_t first = prng_next(rng);
+    princev2xts_t xts;
+    int status = 0;
+
+    prince_xts_init(&xts, dataKey, tweakKey);
+
+    uint8_t* plain = malloc(CHECK_BYTES);
+    uint8_t* expected = malloc(CHECK_BYTES);
+    uint8_t* out = malloc(CHECK_BYTES);
+    uint8_t* buffer = malloc(CHECK_BYTES);
+    if (plain == NULL || expected == NULL || out == NULL || buffer == NULL) {
+        fprintf(stderr, "princev2test: out of memory\n");
+        status = -1; /* error */
+        goto done;
+    }
+
+    for (int i = 0; i < NUM_OF_KNOWN && status == 0; i++) {
+        size_t len = known[i][1];
+
+        for (size_t j = 0; j < len; j++) {
+            plain[j] = j;
+        }
+        if (prince_xts_encrypt_sectors(&xts, known[i][0], len, plain, out, len, 1) != 0 ||
+            loadBigEndian(out) != known[i][2] ||
+            loadBigEndian(out + len - BLOCK_BYTES) != known[i][3]) {
+            status = checkFailed("prince_xts_encrypt_sectors known answer", known[i][0]);
+        }
+    }
+
+    for (int i = 0; i < NUM_OF_CASES && status == 0; i++) {
+        size_t sectorBytes = cases[i][0], len = cases[i][1];
+        size_t lastStart = (len - 1) / sectorBytes * sectorBytes;
+
+        prng_fill(rng, (uint64_t*) plain, CHECK_BYTES / BLOCK_BYTES);
+        for (size_t start = 0; start < len; start += sectorBytes) {
+            size_t bytes = len - start < sectorBytes ? len - start : sectorBytes;
+            xtsSector(dataKey, tweakKey, first + start / sectorBytes, plain + start,
+                      expected + start, bytes);
+        }
+
+        for (int threads = 1; threads <= 4 && status == 0; threads += 3) {
+            memcpy(buffer, plain, len);
+
+            if (prince_xts_encrypt_sectors(&xts, first, sectorBytes, plain, out, len,
+                                           threads) != 0 ||
+                memcmp(out, expected, len) != 0) {
+                status = checkFailed("prince_xts_encrypt_sectors", len);
+            } else if (prince_xts_decrypt_sectors(&xts, first, sectorBytes, out, out, len,
+                                                  threads) != 0 ||
+                       memcmp(out, plain, len) != 0) {
+                status = checkFailed("prince_xts_decrypt_sectors in place", len);
+            } else if (prince_xts_encrypt_sectors(&xts, first, sectorBytes, buffer, buffer,
+                                                  len, threads) != 0 ||
+                       memcmp(buffer, expected, len) != 0) {
+                status = checkFailed("prince_xts_encrypt_sectors in place", len);
+            } else if (prince_xts_decrypt_sectors(&xts, first, sectorBytes, buffer, out, len,
+                                                  threads) != 0 ||
+                       memcmp(out, plain, len) != 0) {
+                status = checkFailed("prince_xts_decrypt_sectors", len);
+            } else if (prince_xts_decrypt_sectors(&xts, first + lastStart / sectorBytes,
+                                                  sectorBytes, expected + lastStart, out,
+                                                  len - lastStart, threads) != 0 ||
+                       memcmp(out, plain + lastStart, len - lastStart) != 0) {
+                status = checkFailed("prince_xts_decrypt_sectors of the last sector", len);
+            }
+        }
+    }
+
+done:
+    free(plain);
+    free(expected);
+    free(out);
+    free(buffer);
+    return status;
+}
+
+/* PMAC of len bytes block by block with prince_encrypt, as written in
+   princev2pmac.h */
+static uint64_t pmacMessage(princev2key_t key, const uint8_t* data, size_t len) {
+    uint64_t l = prince_encrypt(key, 0);
+    size_t m = len == 0 ? 1 : (len + BLOCK_BYTES - 1) / BLOCK_BYTES;
+    uint64_t sum = 0;
+
+    for (size_t i = 1; i < m; i++) {
+        uint64_t offset = 0, power = l;
+
+        for (uint64_t gray = i ^ (i >> 1); gray != 0; gray >>= 1) {
+            if (gray & 1) {
+                offset ^= power;
+            }
+            power = prince_xex_double(power);
+        }
+        sum ^= prince_encrypt(key, loadBigEndian(data + (i - 1) * BLOCK_BYTES) ^ offset);
+    }
+
+    uint8_t last[BLOCK_BYTES] = {0};
+    size_t r = len - (m - 1) * BLOCK_BYTES;
+
+    memcpy(last, data + (m - 1) * BLOCK_BYTES, r);
+    if (r == BLOCK_BYTES) {
+        /* L / x undoes prince_xex_double: the low bit of L tells whether
+           the reduction polynomial was added */
+        uint64_t reduced = l & 1 ? l ^ 0x1b : l;
+        sum ^= (reduced >> 1) | (l & 1 ? (uint64_t) 1 << 63 : 0);
+    } else {
+        last[r] = 0x80;
+    }
+
+    return prince_encrypt(key, sum ^ loadBigEndian(last));
+}
+
+/* prince_pmac and the streaming calls against pmacMessage: the empty
+   message, 1 to 8 bytes (8 takes the L / x path), longer ones and ones
+   long enough for several threads, one shot and cut into pieces, under
+   two keys. The known answers have bytes 0, 1, 2, ... as message */
+static int checkPmac(prng_t* rng) {
+    const size_t lengths[] = {
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 64, 1000, 1 << 18, CHECK_BYTES - 3, CHECK_BYTES
+    };
+    enum{NUM_OF_LENGTHS = sizeof(lengths) / sizeof(lengths[0])};
+    const size_t pieces[] = {1, 7, 8, 13, 4096};
+    enum{NUM_OF_PIECES = sizeof(pieces) / sizeof(pieces[0])};
+    const uint64_t known[][2] = { /* bytes, tag */
+        {0, 0x2ea0b1423b26dade}, {1, 0xc6c7b488791b75a6}, {7, 0xfb827ac110c178b3},
+        {8, 0x8967b296e9ccbecb}, {9, 0x560e87b047bf4e0f}, {16, 0x9ca676851e8cb7d8}
+    };
+    enum{NUM_OF_KNOWN = sizeof(known) / sizeof(known[0])};
+    princev2key_t keys[2] = {key_new(0x0123456789abcdef, 0xfedcba9876543210)};
+    princev2pmackey_t pmacKey;
+    int status = 0;
+
+    /* the second key has the other low bit of L, L / x reduces for one */
+    do {
+        keys[1] = key_new(prng_next(rng), prng_next(rng));
+    } while (((prince_encrypt(keys[0], 0) ^ prince_encrypt(keys[1], 0)) & 1) == 0);
+
+    uint8_t* data = malloc(CHECK_BYTES);
+    if (data == NULL) {
+        fprintf(stderr, "princev2test: out of memory\n");
+        return -1; /* error */
+    }
+
+    prince_pmac_key(&pmacKey, keys[0]);
+    for (size_t j = 0; j < CHECK_BYTES; j++) {
+        data[j] = j;
+    }
+    for (int i = 0; i < NUM_OF_KNOWN && status == 0; i++) {
+        if (prince_pmac(&pmacKey, data, known[i][0], 1) != known[i][1]) {
+            status = checkFailed("prince_pmac known answer", known[i][0]);
+        }
+    }
+
+    prng_fill(rng, (uint64_t*) data, CHECK_BYTES / BLOCK_BYTES);
+
+    for (int k = 0; k < 2 && status == 0; k++) {
+        prince_pmac_key(&pmacKey, keys[k]);
+
+        for (int i = 0; i < NUM_OF_LENGTHS && status == 0; i++) {
+            size_t len = lengths[i];
+            uint64_t tag = pmacMessage(keys[k], data, len);
+
+            for (int threads = 1; threads <= 4 && status == 0; threads += 3) {
+                if (prince_pmac(&pmacKey, data, len, threads) != tag) {
+                    status = checkFailed("prince_pmac", len);
+                }
+
+                for (int p = 0; p < NUM_OF_PIECES && status == 0; p++) {
+                    princev2pmac_t pmac;
+                    size_t done = 0;
+
+                    /* pieces[p] bytes at a time up to half of the message,
+                       the rest in one update that can use the threads */
+                    prince_pmac_init(&pmac, &pmacKey, threads);
+                    while (done < len) {
+                        size_t piece = len - done < pieces[p] ? len - done : pieces[p];
+                        if (done >= len / 2) {
+                            piece = len - done;
+                        }
+                        prince_pmac_update(&pmac, data + done, piece);
+                        done += piece;
+                    }
+
+                    if (prince_pmac_final(&pmac) != tag) {
+                        status = checkFailed("prince_pmac_update", len);
+                    }
+                }
+            }
+        }
+    }
+
+    free(data);
+    return status;
+}
+
+/* the test vectors of the PRINCE paper: plaintext, k0, k1, ciphertext */
+static const uint64_t v1Vectors[][4] = {
+    {0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x818665aa0d02dfda},
+    {0xffffffffffffffff, 0x0000000000000000, 0x0000000000000000, 0x604ae6ca03c20ada},
+    {0x0000000000000000, 0xffffffffffffffff, 0x0000000000000000, 0x9fb51935fc3df524},
+    {0x0000000000000000, 0x0000000000000000, 0xffffffffffffffff, 0x78a54cbe737bb7ef},
+    {0x0123456789abcdef, 0x0000000000000000, 0xfedcba9876543210, 0xae25ad3ca8fa9ccf}
+};
+enum{NUM_OF_V1_VECTORS = sizeof(v1Vectors) / sizeof(v1Vectors[0])};
+
+/* prince_v1_encrypt/prince_v1_decrypt of princev1.h on the paper vectors */
+static int checkV1() {
+    for (int i = 0; i < NUM_OF_V1_VECTORS; i++) {
+        princev2key_t key = key_new(v1Vectors[i][1], v1Vectors[i][2]);
+
+        if (prince_v1_encrypt(key, v1Vectors[i][0]) != v1Vectors[i][3]) {
+            return checkFailed("prince_v1_encrypt", v1Vectors[i][0]);
+        }
+        if (prince_v1_decrypt(key, v1Vectors[i][3]) != v1Vectors[i][0]) {
+            return checkFailed("prince_v1_decrypt", v1Vectors[i][3]);
+        }
+    }
+
+    return 0;
+}
+
+/* the calls every engine offers, checked against the reference code */
+typedef enum {
+    ENGINE_ENCRYPT, ENGINE_DECRYPT,
+    ENGINE_ENCRYPT_CTX, ENGINE_DECRYPT_CTX,
+    ENGINE_ENCRYPT_V1_CTX, ENGINE_DECRYPT_V1_CTX,
+    ENGINE_ENCRYPT_KEYS, ENGINE_DECRYPT_KEYS,
+    NUM_OF_ENGINE_CALLS
+} enginecall_t;
+
+static const char* engineCallNames[NUM_OF_ENGINE_CALLS] = {
+    "prince_engine_encrypt", "prince_engine_decrypt",
+    "prince_engine_encrypt_ctx", "prince_engine_decrypt_ctx",
+    "prince_engine_encrypt_ctx (PRINCE)", "prince_engine_decrypt_ctx (PRINCE)",
+    "prince_engine_encrypt_keys", "prince_engine_decrypt_keys"
+};
+
+/* blocks of the longest engine check, more than a batch of every engine */
+enum{ENGINE_CHECK_BLOCKS = 1000};
+
+static void engineCall(princeengine_t engine, enginecall_t call, princev2key_t key,
+                       const princev2ctx_t* ctx, const princev2ctx_t* v1Ctx,
+                       const princev2key_t* keys, const uint64_t* in, uint64_t* out,
+                       size_t n) {
+    switch (call) {
+    case ENGINE_ENCRYPT:
+        prince_engine_encrypt(engine, key, in, out, n);
+        break;
+    case ENGINE_DECRYPT:
+        prince_engine_decrypt(engine, key, in, out, n);
+        break;
+    case ENGINE_ENCRYPT_CTX:
+        prince_engine_encrypt_ctx(engine, ctx, in, out, n);
+        break;
+    case ENGINE_DECRYPT_CTX:
+        prince_engine_decrypt_ctx(engine, ctx, in, out, n);
+        break;
+    case ENGINE_ENCRYPT_V1_CTX:
+        prince_engine_encrypt_ctx(engine, v1Ctx, in, out, n);
+        break;
+    case ENGINE_DECRYPT_V1_CTX:
+        prince_engine_decrypt_ctx(engine, v1Ctx, in, out, n);
+        break;
+    case ENGINE_ENCRYPT_KEYS:
+        prince_engine_encrypt_keys(engine, keys, in, out, n);
+        break;
+    default:
+        prince_engine_decrypt_keys(engine, keys, in, out, n);
+        break;
+    }
+}
+
+/* what call gives for block i, one block at a time */
+static uint64_t engineCallReference(enginecall_t call, princev2key_t key,
+                                    const princev2key_t* keys, uint64_t block, size_t i) {
+    switch (call) {
+    case ENGINE_ENCRYPT:
+    case ENGINE_ENCRYPT_CTX:
+        return prince_encrypt(key, block);
+    case ENGINE_DECRYPT:
+    case ENGINE_DECRYPT_CTX:
+        return prince_decrypt(key, block);
+    case ENGINE_ENCRYPT_V1_CTX:
+        return prince_v1_encrypt(key, block);
+    case ENGINE_DECRYPT_V1_CTX:
+        return prince_v1_decrypt(key, block);
+    case ENGINE_ENCRYPT_KEYS:
+        return prince_encrypt(keys[i], block);
+    default:
+        return prince_decrypt(keys[i], block);
+    }
+}
+
+/* every engine this CPU supports, not only the one PRINCE_ENGINE_AUTO
+   picked, against the reference code: all calls, lengths around the batch
+   sizes of the engines, in place and not */
+static int checkEngines(prng_t* rng) {
+    const size_t lengths[] = {1, 3, 7, 8, 9, 31, 33, 63, 64, 65, 127, 129, ENGINE_CHECK_BLOCKS};
+    enum{NUM_OF_LENGTHS = sizeof(lengths) / sizeof(lengths[0])};
+    static uint64_t plain[ENGINE_CHECK_BLOCKS], out[ENGINE_CHECK_BLOCKS];
+    static princev2key_t keys[ENGINE_CHECK_BLOCKS];
+    princev2ctx_t ctx, v1Ctx;
+    char check[128];
+
+    for (princeengine_t engine = PRINCE_ENGINE_REFERENCE; engine < NUM_OF_ENGINES; engine++) {
+        if (!prince_engine_supported(engine)) {
+            continue;
+        }
+
+        if (prince_engine_selfTest(engine) != 0) {
+            snprintf(check, sizeof(check), "prince_engine_selfTest of %s",
+                     prince_engine_name(engine));
+            return checkFailed(check, 0);
+        }
+
+        for (int l = 0; l < NUM_OF_LENGTHS; l++) {
+            size_t n = lengths[l];
+            princev2key_t key = key_new(prng_next(rng), prng_next(rng));
+
+            prince_ctx_init(&ctx, key);
+            prince_v1_ctx_init(&v1Ctx, key);
+            for (size_t i = 0; i < n; i++) {
+                keys[i] = key_new(prng_next(rng), prng_next(rng));
+            }
+
+            for (enginecall_t call = 0; call < NUM_OF_ENGINE_CALLS; call++) {
+                for (int inPlace = 0; inPlace <= 1; inPlace++) {
+                    prng_fill(rng, plain, n);
+                    if (inPlace) {
+                        memcpy(out, plain, n * sizeof(uint64_t));
+                    }
+                    engineCall(engine, call, key, &ctx, &v1Ctx, keys,
+                               inPlace ? out : plain, out, n);
+
+                    for (size_t i = 0; i < n; i++) {
+                        if (out[i] != engineCallReference(call, key, keys, plain[i], i)) {
+                            snprintf(check, sizeof(check), "%s of %s on %zu blocks%s",
+                                     engineCallNames[call], prince_engine_name(engine), n,
+                                     inPlace ? " in place" : "");
+                            return checkFailed(check, plain[i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* more than two bitsliced batches, none of the engines fills the last one */
+enum{ROUNDS_CHECK_BLOCKS = 2 * 64 + 3};
+
+/* prince_engine_encrypt_rounds of every supported engine against
+   prince_core_rounds for every forward/middle/backward split under a
+   random key list, prince_engine_decrypt_rounds back in place, and
+   prince_encrypt_rounds_blocks/prince_decrypt_rounds_blocks on the engine
+   PRINCE_ENGINE_AUTO picked */
+static int checkRounds(prng_t* rng) {
+    static uint64_t plain[ROUNDS_CHECK_BLOCKS], out[ROUNDS_CHECK_BLOCKS];
+    uint64_t rk[NUM_OF_KEY_ADDITIONS];
+    char check[128];
+
+    for (princeengine_t engine = PRINCE_ENGINE_AUTO; engine < NUM_OF_ENGINES; engine++) {
+        if (!prince_engine_supported(engine)) {
+            continue;
+        }
+
+        for (int forward = 0; forward <= NUM_OF_FORWARD_ROUNDS; forward++) {
+            for (int middle = 0; middle <= 1; middle++) {
+                for (int backward = 0; backward <= NUM_OF_INVERSE_ROUNDS; backward++) {
+                    prng_fill(rng, rk, NUM_OF_KEY_ADDITIONS);
+                    prng_fill(rng, plain, ROUNDS_CHECK_BLOCKS);
+
+                    snprintf(check, sizeof(check), "rounds %d/%d/%d of %s", forward, middle,
+                             backward, prince_engine_name(engine));
+
+                    int status = engine == PRINCE_ENGINE_AUTO ?
+                        prince_encrypt_rounds_blocks(rk, forward, middle, backward, plain, out,
+                                                     ROUNDS_CHECK_BLOCKS) :
+                        prince_engine_encrypt_rounds(engine, rk, forward, middle, backward,
+                                                     plain, out, ROUNDS_CHECK_BLOCKS);
+                    if (status != 0) {
+                        return checkFailed(check, 0);
+                    }
+                    for (int i = 0; i < ROUNDS_CHECK_BLOCKS; i++) {
+                        if (out[i] != prince_core_rounds(rk, plain[i], forward, middle,
+                                                         backward)) {
+                            return checkFailed(check, plain[i]);
+                        }
+                    }
+
+                    status = engine == PRINCE_ENGINE_AUTO ?
+                        prince_decrypt_rounds_blocks(rk, forward, middle, backward, out, out,
+                                                     ROUNDS_CHECK_BLOCKS) :
+                        prince_engine_decrypt_rounds(engine, rk, forward, middle, backward,
+                                                     out, out, ROUNDS_CHECK_BLOCKS);
+                    if (status != 0 || memcmp(out, plain, sizeof(plain)) != 0) {
+                        snprintf(check, sizeof(check), "inverse rounds %d/%d/%d of %s", forward,
+                                 middle, backward, prince_engine_name(engine));
+                        return checkFailed(check, 0);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* more lines than princev2xex.c encrypts per tile */
+enum{XEX_CHECK_LINES = 300};
+
+/* prince_xex_encrypt_lines/prince_xex_decrypt_lines against the formula of
+   princev2xex.h, C_j = E(P_j ^ D_j) ^ D_j with D_j = E(a / 64) * x^(j + 1),
+   for lines at random addresses that are mostly not line aligned, in place
+   and not */
+static int checkXex(prng_t* rng) {
+    static uint64_t addresses[XEX_CHECK_LINES];
+    static uint64_t plain[XEX_CHECK_LINES * XEX_LINE_BLOCKS];
+    static uint64_t expected[XEX_CHECK_LINES * XEX_LINE_BLOCKS];
+    static uint64_t out[XEX_CHECK_LINES * XEX_LINE_BLOCKS];
+    princev2key_t key = key_new(prng_next(rng), prng_next(rng));
+    princev2ctx_t ctx;
+
+    prince_ctx_init(&ctx, key);
+    prng_fill(rng, addresses, XEX_CHECK_LINES);
+    prng_fill(rng, plain, XEX_CHECK_LINES * XEX_LINE_BLOCKS);
+
+    for (int i = 0; i < XEX_CHECK_LINES; i++) {
+        uint64_t d = prince_encrypt(key, addresses[i] / XEX_LINE_BYTES);
+
+        for (int j = 0; j < XEX_LINE_BLOCKS; j++) {
+            /* times x: shift, and reduce by x^64 = x^4 + x^3 + x + 1 */
+            d = (d << 1) ^ (d >> 63 ? 0x1b : 0);
+            expected[i * XEX_LINE_BLOCKS + j] =
+                prince_encrypt(key, plain[i * XEX_LINE_BLOCKS + j] ^ d) ^ d;
+        }
+    }
+
+    size_t bytes = sizeof(out);
+
+    prince_xex_encrypt_lines(&ctx, addresses, plain, out, XEX_CHECK_LINES);
+    if (memcmp(out, expected, bytes) != 0) {
+        return checkFailed("prince_xex_encrypt_lines", XEX_CHECK_LINES);
+    }
+    prince_xex_decrypt_lines(&ctx, addresses, out, out, XEX_CHECK_LINES);
+    if (memcmp(out, plain, bytes) != 0) {
+        return checkFailed("prince_xex_decrypt_lines in place", XEX_CHECK_LINES);
+    }
+    prince_xex_encrypt_lines(&ctx, addresses, out, out, XEX_CHECK_LINES);
+    if (memcmp(out, expected, bytes) != 0) {
+        return checkFailed("prince_xex_encrypt_lines in place", XEX_CHECK_LINES);
+    }
+    prince_xex_decrypt_lines(&ctx, addresses, expected, out, XEX_CHECK_LINES);
+    if (memcmp(out, plain, bytes) != 0) {
+        return checkFailed("prince_xex_decrypt_lines", XEX_CHECK_LINES);
+    }
+
+    return 0;
+}
+
+/* long enough for four CTR threads, not a whole number of tiles */
+enum{CTR_CHECK_BLOCKS = 70001};
+
+/* prince_ctr_keystream against prince_encrypt(key, counter + i) across the
+   wrap of the counter, the same output on 1 to 4 threads and one per CPU,
+   and prince_ctr_xor with a partial last block, in place and not, against
+   the keystream written most significant byte first */
+static int checkCtr(prng_t* rng) {
+    const int threads[] = {2, 3, 4, 0};
+    enum{NUM_OF_THREADS = sizeof(threads) / sizeof(threads[0])};
+    size_t len = CTR_CHECK_BLOCKS * BLOCK_BYTES - 3;
+    princev2key_t key = key_new(prng_next(rng), prng_next(rng));
+    uint64_t counter = UINT64_MAX - CTR_CHECK_BLOCKS / 2;
+    int status = 0;
+
+    uint64_t* stream = malloc(CTR_CHECK_BLOCKS * sizeof(uint64_t));
+    uint64_t* other = malloc(CTR_CHECK_BLOCKS * sizeof(uint64_t));
+    uint8_t* in = malloc(len);
+    uint8_t* out = malloc(len);
+    if (stream == NULL || other == NULL || in == NULL || out == NULL) {
+        fprintf(stderr, "princev2test: out of memory\n");
+        status = -1; /* error */
+        goto done;
+    }
+
+    prince_ctr_keystream(key, counter, stream, CTR_CHECK_BLOCKS, 1);
+    for (size_t i = 0; i < CTR_CHECK_BLOCKS && status == 0; i++) {
+        if (stream[i] != prince_encrypt(key, counter + i)) {
+            status = checkFailed("prince_ctr_keystream", counter + i);
+        }
+    }
+
+    for (int t = 0; t < NUM_OF_THREADS && status == 0; t++) {
+        prince_ctr_keystream(key, counter, other, CTR_CHECK_BLOCKS, threads[t]);
+        if (memcmp(other, stream, CTR_CHECK_BLOCKS * sizeof(uint64_t)) != 0) {
+            status = checkFailed("prince_ctr_keystream on several threads", threads[t]);
+        }
+    }
+
+    for (int t = 0; t < NUM_OF_THREADS && status == 0; t++) {
+        prng_fill(rng, other, CTR_CHECK_BLOCKS);
+        memcpy(in, other, len);
+
+        prince_ctr_xor(key, counter, in, out, len, threads[t]);
+        for (size_t b = 0; b < len && status == 0; b++) {
+            uint8_t byte = stream[b / BLOCK_BYTES] >> (8 * (BLOCK_BYTES - 1 - b % BLOCK_BYTES));
+            if (out[b] != (in[b] ^ byte)) {
+                status = checkFailed("prince_ctr_xor", b);
+            }
+        }
+
+        prince_ctr_xor(key, counter, out, out, len, threads[t]);
+        if (status == 0 && memcmp(out, in, len) != 0) {
+            status = checkFailed("prince_ctr_xor in place", threads[t]);
+        }
+    }
+
+done:
+    free(stream);
+    free(other);
+    free(in);
+    free(out);
+    return status;
+}
+
+/* Returns 0 if every check passes */
+static int check() {
+    prng_t rng;
+
+    prng_seed(&rng, CHECK_SEED);
+
+    if (checkLayers(&rng) != 0 || checkFast(&rng) != 0 || checkXts(&rng) != 0 ||
+        checkPmac(&rng) != 0 || checkV1() != 0 || checkEngines(&rng) != 0 ||
+        checkRounds(&rng) != 0 || checkCtr(&rng) != 0 || checkXex(&rng) != 0) {
+        return -1; /* error */
+    }
+
+    return 0;
+}
+
+/* vectors per substream and per output buffer in generate mode */
+enum{GENERATE_CHUNK = 8192};
+enum{GENERATE_MAX_THREADS = 64};
+
+/* 64-bit words per vector (k0, k1, plaintext, ciphertext) */
+enum{MAX_VECTOR_WORDS = 4};
+
+typedef struct generatebuffer {
+    char data[GENERATE_CHUNK * (KEY_HEX_LENGTH + 1 + 2 * (HEX_DIGITS + 1))];
+    size_t len;
+    int full;
+} generatebuffer_t;
+
+/* every worker fills chunks worker, worker + threads, ... into its two
+   buffers in turn, the main thread writes them out in chunk order */
+typedef struct generator {
+    uint64_t seed;
+    uint64_t num;
+    int fixedKey;
+    princev2key_t key;
+    int binary;
+    int threads;
+    uint64_t chunks;
+    generatebuffer_t (*buffers)[2];
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} generator_t;
+
+typedef struct generateworker {
+    generator_t* gen;
+    int index;
+} generateworker_t;
+
+static void generateChunk(const generator_t* gen, prng_t* rng, uint64_t chunk,
+                          generatebuffer_t* buffer) {
+    uint64_t first = chunk * GENERATE_CHUNK;
+    size_t n = gen->num - first < GENERATE_CHUNK ? gen->num - first : GENERATE_CHUNK;
+    uint64_t words[GENERATE_CHUNK * 3];
+    uint64_t plain[GENERATE_CHUNK], cipher[GENERATE_CHUNK];
+    princev2key_t keys[GENERATE_CHUNK];
+
+    if (gen->fixedKey) {
+        prng_fill(rng, plain, n);
+        prince_encrypt_blocks(gen->key, plain, cipher, n);
+    } else {
+        prng_fill(rng, words, 3 * n);
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = key_new(words[3 * i], words[3 * i + 1]);
+            plain[i] = words[3 * i + 2];
+        }
+        prince_encrypt_keys_blocks(keys, plain, cipher, n);
+    }
+
+    char* out = buffer->data;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t record[MAX_VECTOR_WORDS];
+        int count = 0;
+
+        if (!gen->fixedKey) {
+            record[count++] = words[3 * i];
+            record[count++] = words[3 * i + 1];
+        }
+        record[count++] = plain[i];
+        record[count++] = cipher[i];
+
+        if (gen->binary) {
+            for (int w = 0; w < count; w++) {
+                storeBigEndian((uint8_t*) out, record[w]);
+                out += sizeof(uint64_t);
+            }
+        } else {
+            int w = 0;
+            if (!gen->fixedKey) {
+                hex_encode64(record[w++], out);
+                out = putHex(out + HEX_DIGITS, record[w++], ' ');
+            }
+            out = putHex(out, record[w++], ' ');
+            out = putHex(out, record[w++], '\n');
+        }
+    }
+
+    buffer->len = out - buffer->data;
+}
+
+static void* generateWorker(void* arg) {
+    generateworker_t* worker = arg;
+    generator_t* gen = worker->gen;
+    prng_t rng;
+    int turn = 0;
+
+    /* chunk c uses the stream of the seed jumped c times */
+    prng_seed(&rng, gen->seed);
+    for (int j = 0; j < worker->index; j++) {
+        prng_jump(&rng);
+    }
+
+    for (uint64_t chunk = worker->index; chunk < gen->chunks; chunk += gen->threads) {
+        generatebuffer_t* buffer = &gen->buffers[worker->index][turn];
+
+        pthread_mutex_lock(&gen->lock);
+        while (buffer->full) {
+            pthread_cond_wait(&gen->changed, &gen->lock);
+        }
+        pthread_mutex_unlock(&gen->lock);
+
+        prng_t chunkRng = rng;
+        generateChunk(gen, &chunkRng, chunk, buffer);
+
+        pthread_mutex_lock(&gen->lock);
+        buffer->full = 1;
+        pthread_cond_broadcast(&gen->changed);
+        pthread_mutex_unlock(&gen->lock);
+
+        for (int j = 0; j < gen->threads; j++) {
+            prng_jump(&rng);
+        }
+        turn ^= 1;
+    }
+
+    return NULL;
+}
+
+/* princev2test --generate N seed [k0 k1] [--threads T] [--binary] [--output file] */
+static int generateMode(int argc, char* argv[]) {
+    generator_t gen = {.fixedKey = 0, .binary = 0, .threads = 0};
+    const char* output = NULL;
+    const char* positional[4];
+    int numPositional = 0;
+    char* end;
+
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--binary")) {
+            gen.binary = 1;
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            gen.threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (numPositional < 4) {
+            positional[numPositional++] = argv[i];
+        } else {
+            numPositional = -1;
+            break;
+        }
+    }
+
+    if (numPositional != 2 && numPositional != 4) {
+        fprintf(stderr, "Usage: %s --generate N seed [k0 k1] [--threads T] [--binary] "
+                "[--output file]\n", argv[0]);
+        return -1;
+    }
+
+    gen.num = strtoull(positional[0], &end, 0);
+    if (*end != '\0') {
+        fprintf(stderr, "failed to parse N = %s\n", positional[0]);
+        return -1;
+    }
+    gen.seed = strtoull(positional[1], &end, 0);
+    if (*end != '\0') {
+        fprintf(stderr, "failed to parse seed = %s\n", positional[1]);
+        return -1;
+    }
+    if (numPositional == 4) {
+        uint64_t k0, k1;
+        if (hex_parse(positional[2], strlen(positional[2]), &k0) != 0 ||
+            hex_parse(positional[3], strlen(positional[3]), &k1) != 0) {
+            fprintf(stderr, "failed to parse key %s %s\n", positional[2], positional[3]);
+            return -1;
+        }
+        gen.fixedKey = 1;
+        gen.key = key_new(k0, k1);
+    }
+
+    if (gen.threads <= 0) {
+        gen.threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    gen.chunks = (gen.num + GENERATE_CHUNK - 1) / GENERATE_CHUNK;
+    if (gen.threads > GENERATE_MAX_THREADS) {
+        gen.threads = GENERATE_MAX_THREADS;
+    }
+    if ((uint64_t) gen.threads > gen.chunks) {
+        gen.threads = gen.chunks > 0 ? gen.chunks : 1;
+    }
+
+    FILE* out = output == NULL ? stdout : fopen(output, gen.binary ? "wb" : "w");
+    if (out == NULL) {
+        perror(output);
+        return -1;
+    }
+
+    gen.buffers = calloc(gen.threads, sizeof(*gen.buffers));
+    if (gen.buffers == NULL) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        return -1;
+    }
+    pthread_mutex_init(&gen.lock, NULL);
+    pthread_cond_init(&gen.changed, NULL);
+
+    generateworker_t workers[GENERATE_MAX_THREADS];
+    pthread_t tids[GENERATE_MAX_THREADS];
+    for (int t = 0; t < gen.threads; t++) {
+        workers[t].gen = &gen;
+        workers[t].index = t;
+        if (pthread_create(&tids[t], NULL, generateWorker, &workers[t]) != 0) {
+            fprintf(stderr, "%s: cannot start thread %d\n", argv[0], t);
+            exit(-1);
+        }
+    }
+
+    for (uint64_t chunk = 0; chunk < gen.chunks; chunk++) {
+        generatebuffer_t* buffer = &gen.buffers[chunk % gen.threads][(chunk / gen.threads) % 2];
+
+        pthread_mutex_lock(&gen.lock);
+        while (!buffer->full) {
+            pthread_cond_wait(&gen.changed, &gen.lock);
+        }
+        pthread_mutex_unlock(&gen.lock);
+
+        fwrite(buffer->data, 1, buffer->len, out);
+
+        pthread_mutex_lock(&gen.lock);
+        buffer->full = 0;
+        pthread_cond_broadcast(&gen.changed);
+        pthread_mutex_unlock(&gen.lock);
+    }
+
+    for (int t = 0; t < gen.threads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+
+    int status = 0;
+    if (fflush(out) != 0 || ferror(out) || (out != stdout && fclose(out) != 0)) {
+        perror(output == NULL ? "stdout" : output);
+        status = -1;
+    }
+
+    pthread_cond_destroy(&gen.changed);
+    pthread_mutex_destroy(&gen.lock);
+    free(gen.buffers);
+    return status;
+}
+
 int main(int argc, char* argv[]) {
-    // seed random number generator
-    srand(time(NULL));
+    if (argc > 1 && !strcmp(argv[1], "--generate")) {
+        return generateMode(argc, argv);
+    }
+
+    // random keys and plaintexts come from this thread's generator
+    prng_t* rng = prng_thread();
 
     int mode; // whether key is FIXED_KEY or RANDOM_KEY
     if (argc == 2) {
@@ -39,8 +994,13 @@ int main(int argc, char* argv[]) {
         mode = FIXED_KEY;
     } else {
         fprintf(stderr,
-                "Usage: %s <Number_of_tests> [k0 k1]\n",
-            argv[0]);
+                "Usage: %s <Number_of_tests> [k0 k1]\n"
+                "       %s --generate N seed [k0 k1] [--threads T] [--binary] [--output file]\n",
+            argv[0], argv[0]);
+        return -1;
+    }
+
+    if (check() != 0) {
         return -1;
     }
 
@@ -94,6 +1054,17 @@ int main(int argc, char* argv[]) {
     ptest = prince_decrypt(key_new(k0, k1), c);
     printf("%016lx%016lx %016lx %016lx %016lx\n", k0, k1, p, c, ptest);
 
+    // PRINCE (v1) testvectors
+    printf("\nPRINCE v1\n");
+    for (int i = 0; i < NUM_OF_V1_VECTORS; i++) {
+        p = v1Vectors[i][0];
+        k0 = v1Vectors[i][1];
+        k1 = v1Vectors[i][2];
+        c = prince_v1_encrypt(key_new(k0, k1), p);
+        ptest = prince_v1_decrypt(key_new(k0, k1), c);
+        printf("%016lx%016lx %016lx %016lx %016lx\n", k0, k1, p, c, ptest);
+    }
+
     printf("\n");
 
     // process key
@@ -115,8 +1086,8 @@ int main(int argc, char* argv[]) {
             }
         }
     } else {
-        k0 = llrand();
-        k1 = llrand();
+        k0 = prng_next(rng);
+        k1 = prng_next(rng);
     }
 
     princev2key_t key = key_new(k0, k1);
@@ -131,18 +1102,45 @@ int main(int argc, char* argv[]) {
     printf("Plaintext        Ciphertext       decrypted CT\n");
 
     // create test vectors
-    for (int i = 0; i < num; i++) {
-        // initialize
-        uint64_t plaintext = llrand();
-        uint64_t ciphertext = prince_encrypt(key, plaintext);
-        uint64_t plaintext_test = prince_decrypt(key, ciphertext);
+    static char text[OUTPUT_BUFFER_BYTES];
+    char* line = text;
+
+    // vectors are encrypted VECTOR_CHUNK at a time, every one under its own
+    // key in random key mode
+    static princev2key_t keys[VECTOR_CHUNK];
+    static uint64_t plaintext[VECTOR_CHUNK], ciphertext[VECTOR_CHUNK];
+    static uint64_t plaintext_test[VECTOR_CHUNK];
 
+    for (int first = 0; first < num; first += VECTOR_CHUNK) {
+        int n = num - first < VECTOR_CHUNK ? num - first : VECTOR_CHUNK;
+
+        prng_fill(rng, plaintext, n);
         if (mode == RANDOM_KEY) {
-            princev2key_toString(key, keyStr);
-            printf ("%s ", keyStr);
+            for (int i = 0; i < n; i++) {
+                keys[i] = key;
+                key_getRandom(&key);
+            }
+            prince_encrypt_keys_blocks(keys, plaintext, ciphertext, n);
+            prince_decrypt_keys_blocks(keys, ciphertext, plaintext_test, n);
+        } else {
+            prince_encrypt_blocks(key, plaintext, ciphertext, n);
+            prince_decrypt_blocks(key, ciphertext, plaintext_test, n);
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (mode == RANDOM_KEY) {
+                hex_encode64(keys[i].k0, line);
+                line = putHex(line + HEX_DIGITS, keys[i].k1, ' ');
+            }
+            line = putHex(line, plaintext[i], ' ');
+            line = putHex(line, ciphertext[i], ' ');
+            line = putHex(line, plaintext_test[i], '\n');
 
-            key_getRandom(&key);
+            if (line + MAX_LINE_LENGTH > text + sizeof(text)) {
+                fwrite(text, 1, line - text, stdout);
+                line = text;
+            }
         }
-        printf("%016lx %016lx %016lx\n", plaintext, ciphertext, plaintext_test);
     }
+    fwrite(text, 1, line - text, stdout);
 }
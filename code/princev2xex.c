@@ -0,0 +1,80 @@
+/**
+princev2xex.c
+
+Address tweaked cache line mode on top of PRINCEv2
+
+Lines are processed in tiles of XEX_TILE_LINES: the line numbers of a tile
+are encrypted in one engine call, the eight masks of every line follow by
+doubling, and the masked blocks of the whole tile go through a second
+engine call. Both calls use the key expanded once in the caller's ctx.
+**/
+
+#include <assert.h>
+
+#include "princev2xex.h"
+#include "princev2engine.h"
+
+/* lines per tile, the blocks of a tile fit into the L1 cache next to the masks */
+enum {XEX_TILE_LINES = 128};
+
+static void prince_xex_lines(const princev2ctx_t* ctx, princemode_t mode,
+                             const uint64_t* addresses, const uint64_t* in, uint64_t* out,
+                             size_t lines) {
+    uint64_t nonce[XEX_TILE_LINES];
+    uint64_t mask[XEX_TILE_LINES * XEX_LINE_BLOCKS];
+    uint64_t tile[XEX_TILE_LINES * XEX_LINE_BLOCKS];
+
+    while (lines > 0) {
+        size_t count = lines < XEX_TILE_LINES ? lines : XEX_TILE_LINES;
+        size_t blocks = count * XEX_LINE_BLOCKS;
+
+        for (size_t i = 0; i < count; i++) {
+            nonce[i] = addresses[i] / XEX_LINE_BYTES;
+        }
+        prince_engine_encrypt_ctx(PRINCE_ENGINE_AUTO, ctx, nonce, nonce, count);
+
+        for (size_t i = 0; i < count; i++) {
+            uint64_t d = nonce[i];
+
+            for (size_t j = 0; j < XEX_LINE_BLOCKS; j++) {
+                d = prince_xex_double(d);
+                mask[i * XEX_LINE_BLOCKS + j] = d;
+            }
+        }
+
+        for (size_t b = 0; b < blocks; b++) {
+            tile[b] = in[b] ^ mask[b];
+        }
+
+        if (mode == ENC) {
+            prince_engine_encrypt_ctx(PRINCE_ENGINE_AUTO, ctx, tile, tile, blocks);
+        } else {
+            prince_engine_decrypt_ctx(PRINCE_ENGINE_AUTO, ctx, tile, tile, blocks);
+        }
+
+        for (size_t b = 0; b < blocks; b++) {
+            out[b] = tile[b] ^ mask[b];
+        }
+
+        addresses += count;
+        in += blocks;
+        out += blocks;
+        lines -= count;
+    }
+}
+
+void prince_xex_encrypt_lines(const princev2ctx_t* ctx, const uint64_t* addresses,
+                              const uint64_t* in, uint64_t* out, size_t lines) {
+    assert(ctx != NULL);
+    assert((addresses != NULL && in != NULL && out != NULL) || lines == 0);
+
+    prince_xex_lines(ctx, ENC, addresses, in, out, lines);
+}
+
+void prince_xex_decrypt_lines(const princev2ctx_t* ctx, const uint64_t* addresses,
+                              const uint64_t* in, uint64_t* out, size_t lines) {
+    assert(ctx != NULL);
+    assert((addresses != NULL && in != NULL && out != NULL) || lines == 0);
+
+    prince_xex_lines(ctx, DEC, addresses, in, out, lines);
+}
@@ -0,0 +1,45 @@
+/**
+princev2xex.h
+
+Interface for the address tweaked cache line mode on top of PRINCEv2
+
+A line is XEX_LINE_BLOCKS blocks (64 bytes) of memory at a physical
+address, of which the low 6 bits are ignored. Block j of the line at
+address a is encrypted as
+
+    C_j = E(P_j ^ D_j) ^ D_j  with  D_j = E(a / XEX_LINE_BYTES) * x^(j + 1),
+
+the product taken in GF(2^64) = GF(2)[x] / (x^64 + x^4 + x^3 + x + 1). This
+is XEX with the line number as nonce, encrypted under the same key as the
+data. The powers of x start at 1, so no mask equals an encrypted line
+number itself. Moving a line to another address or swapping blocks within
+it changes its plaintext.
+**/
+
+#ifndef _PRINCE_XEX_
+#define _PRINCE_XEX_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "princev2.h"
+
+enum {XEX_LINE_BLOCKS = 8};
+enum {XEX_LINE_BYTES = XEX_LINE_BLOCKS * sizeof(uint64_t)};
+
+/* multiplies a mask by x in GF(2^64) */
+static inline uint64_t prince_xex_double(uint64_t mask) {
+    return (mask << 1) ^ (-(mask >> 63) & 0x1b);
+}
+
+/* encrypts/decrypts lines lines from in to out under the key expanded in
+   ctx, line i being at addresses[i]. in and out hold XEX_LINE_BLOCKS
+   blocks per line and may be the same buffer. The line numbers and the
+   data go through prince_engine_encrypt_ctx/prince_engine_decrypt_ctx in
+   batches, so the cost per line falls with the number of lines per call */
+void prince_xex_encrypt_lines(const princev2ctx_t* ctx, const uint64_t* addresses,
+                              const uint64_t* in, uint64_t* out, size_t lines);
+void prince_xex_decrypt_lines(const princev2ctx_t* ctx, const uint64_t* addresses,
+                              const uint64_t* in, uint64_t* out, size_t lines);
+
+#endif
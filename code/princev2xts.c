@@ -0,0 +1,248 @@
+/**
+princev2xts.c
+
+XTS-like sector mode on top of PRINCEv2
+
+The sectors are cut into one contiguous range per thread, like the blocks
+in princev2ctr.c. A worker encrypts the numbers of XTS_TWEAK_SECTORS
+sectors with one engine call under the tweak key, then runs every sector
+in tiles of XTS_TILE_BLOCKS masked blocks through the engine under the
+data key. Only the stolen block of a sector with a partial tail goes
+through prince_encrypt_ctx/prince_decrypt_ctx on its own.
+**/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "princev2xts.h"
+#include "princev2ctr.h"
+#include "princev2engine.h"
+#include "princev2xex.h"
+#include "misc.h"
+
+/* blocks per tile, a multiple of every engine's batch size */
+enum {XTS_TILE_BLOCKS = 1024};
+
+/* sector numbers per tweak engine call */
+enum {XTS_TWEAK_SECTORS = 64};
+
+/* ranges smaller than this are not worth a thread */
+enum {XTS_MIN_BYTES_PER_THREAD = 16 * XTS_TILE_BLOCKS * sizeof(uint64_t)};
+
+enum {BLOCK_BYTES = sizeof(uint64_t)};
+
+typedef struct xtsjob {
+    const princev2xts_t* xts;
+    princemode_t mode;
+    uint64_t sector;      /* number of the first sector of the range */
+    size_t sectorBytes;
+    const uint8_t* in;
+    uint8_t* out;
+    size_t len;
+} xtsjob_t;
+
+static uint64_t prince_xts_block(const princev2xts_t* xts, princemode_t mode,
+                                 uint64_t block, uint64_t mask) {
+    block ^= mask;
+    block = mode == ENC ? prince_encrypt_ctx(&xts->data, block)
+                        : prince_decrypt_ctx(&xts->data, block);
+    return block ^ mask;
+}
+
+/* the partial tail of r bytes after m full blocks, mask is T_{m - 1}. For
+   encryption block m - 1 is already done, for decryption it is not */
+static void prince_xts_steal(const princev2xts_t* xts, princemode_t mode, uint64_t mask,
+                             const uint8_t* in, uint8_t* out, size_t m, size_t r) {
+    uint8_t head[BLOCK_BYTES], tail[BLOCK_BYTES];
+    uint64_t next = prince_xex_double(mask);
+    const uint8_t* partial = in + m * BLOCK_BYTES;
+    uint8_t* last = out + (m - 1) * BLOCK_BYTES;
+
+    /* encryption: head is C'_{m-1} = E(P_{m-1}) under T_{m-1}, decryption:
+       head is P'_{m-1} = D(C_{m-1}) under T_m */
+    if (mode == ENC) {
+        memcpy(head, last, BLOCK_BYTES);
+    } else {
+        uint64_t block = loadBigEndian(in + (m - 1) * BLOCK_BYTES);
+        storeBigEndian(head, prince_xts_block(xts, DEC, block, next));
+    }
+
+    memcpy(tail, partial, r);
+    memcpy(tail + r, head + r, BLOCK_BYTES - r);
+    memcpy(out + m * BLOCK_BYTES, head, r);
+
+    storeBigEndian(last, prince_xts_block(xts, mode, loadBigEndian(tail),
+                                          mode == ENC ? next : mask));
+}
+
+/* one sector of len bytes, tweak being its encrypted number */
+static void prince_xts_sector(const princev2xts_t* xts, princemode_t mode, uint64_t tweak,
+                              const uint8_t* in, uint8_t* out, size_t len) {
+    uint64_t tile[XTS_TILE_BLOCKS], mask[XTS_TILE_BLOCKS];
+    size_t m = len / BLOCK_BYTES, r = len % BLOCK_BYTES;
+    /* decryption of a stolen sector leaves block m - 1 to prince_xts_steal */
+    size_t bulk = mode == DEC && r > 0 ? m - 1 : m;
+    uint64_t d = tweak, previous = tweak; /* T_done and T_{done - 1} */
+
+    for (size_t done = 0; done < bulk; ) {
+        size_t count = bulk - done < XTS_TILE_BLOCKS ? bulk - done : XTS_TILE_BLOCKS;
+        const uint8_t* src = in + done * BLOCK_BYTES;
+        uint8_t* dst = out + done * BLOCK_BYTES;
+
+        for (size_t i = 0; i < count; i++) {
+            mask[i] = d;
+            previous = d;
+            d = prince_xex_double(d);
+            tile[i] = loadBigEndian(src + i * BLOCK_BYTES) ^ mask[i];
+        }
+
+        if (mode == ENC) {
+            prince_engine_encrypt_ctx(PRINCE_ENGINE_AUTO, &xts->data, tile, tile, count);
+        } else {
+            prince_engine_decrypt_ctx(PRINCE_ENGINE_AUTO, &xts->data, tile, tile, count);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            storeBigEndian(dst + i * BLOCK_BYTES, tile[i] ^ mask[i]);
+        }
+
+        done += count;
+    }
+
+    if (r > 0) {
+        prince_xts_steal(xts, mode, bulk == m ? previous : d, in, out, m, r);
+    }
+}
+
+static void prince_xts_run(const xtsjob_t* job) {
+    uint64_t tweak[XTS_TWEAK_SECTORS];
+    size_t sectors = (job->len + job->sectorBytes - 1) / job->sectorBytes;
+    const uint8_t* in = job->in;
+    uint8_t* out = job->out;
+    size_t len = job->len;
+
+    for (size_t s = 0; s < sectors; s += XTS_TWEAK_SECTORS) {
+        size_t count = sectors - s < XTS_TWEAK_SECTORS ? sectors - s : XTS_TWEAK_SECTORS;
+
+        for (size_t i = 0; i < count; i++) {
+            tweak[i] = job->sector + s + i;
+        }
+        prince_engine_encrypt_ctx(PRINCE_ENGINE_AUTO, &job->xts->tweak, tweak, tweak, count);
+
+        for (size_t i = 0; i < count; i++) {
+            size_t bytes = len < job->sectorBytes ? len : job->sectorBytes;
+
+            prince_xts_sector(job->xts, job->mode, tweak[i], in, out, bytes);
+            in += bytes;
+            out += bytes;
+            len -= bytes;
+        }
+    }
+}
+
+static void* prince_xts_worker(void* arg) {
+    prince_xts_run((const xtsjob_t*) arg);
+    return NULL;
+}
+
+/* splits the sectors into one range per thread */
+static void prince_xts_parallel(const xtsjob_t* job, int threads) {
+    xtsjob_t jobs[XTS_MAX_THREADS];
+    pthread_t tids[XTS_MAX_THREADS];
+    int started[XTS_MAX_THREADS];
+    size_t sectors = (job->len + job->sectorBytes - 1) / job->sectorBytes;
+
+    /* short buffers do not ask for the number of CPUs, it is a system call */
+    if (job->len < 2 * XTS_MIN_BYTES_PER_THREAD) {
+        threads = 1;
+    } else if (threads <= 0) {
+        threads = prince_ctr_threads();
+    }
+    if (threads > XTS_MAX_THREADS) {
+        threads = XTS_MAX_THREADS;
+    }
+    if ((size_t) threads > job->len / XTS_MIN_BYTES_PER_THREAD) {
+        threads = job->len / XTS_MIN_BYTES_PER_THREAD;
+    }
+    if ((size_t) threads > sectors) {
+        threads = sectors;
+    }
+    if (threads <= 1) {
+        prince_xts_run(job);
+        return;
+    }
+
+    size_t start = 0;
+    for (int t = 0; t < threads; t++) {
+        size_t end = sectors * (t + 1) / threads;
+
+        jobs[t] = *job;
+        jobs[t].sector = job->sector + start;
+        jobs[t].in = job->in + start * job->sectorBytes;
+        jobs[t].out = job->out + start * job->sectorBytes;
+        jobs[t].len = (t == threads - 1 ? job->len : end * job->sectorBytes) -
+                      start * job->sectorBytes;
+        start = end;
+    }
+
+    /* the calling thread takes the first range itself */
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&tids[t], NULL, prince_xts_worker, &jobs[t]) == 0;
+    }
+
+    prince_xts_run(&jobs[0]);
+
+    /* ranges whose thread failed to start are done here */
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            prince_xts_run(&jobs[t]);
+        }
+    }
+}
+
+static int prince_xts_sectors(const princev2xts_t* xts, princemode_t mode,
+                              uint64_t firstSector, size_t sectorBytes, const uint8_t* in,
+                              uint8_t* out, size_t len, int threads) {
+    assert(xts != NULL);
+    assert((in != NULL && out != NULL) || len == 0);
+
+    if (sectorBytes < XTS_MIN_SECTOR_BYTES) {
+        fprintf(stderr, "prince_xts_sectors: sectors have to be at least %d bytes, not %zu\n",
+                XTS_MIN_SECTOR_BYTES, sectorBytes);
+        return -1; /* error */
+    }
+    if (len % sectorBytes != 0 && len % sectorBytes < XTS_MIN_SECTOR_BYTES) {
+        fprintf(stderr, "prince_xts_sectors: the last sector has %zu bytes, it has to have "
+                "at least %d\n", len % sectorBytes, XTS_MIN_SECTOR_BYTES);
+        return -1; /* error */
+    }
+
+    xtsjob_t job = {.xts = xts, .mode = mode, .sector = firstSector,
+                    .sectorBytes = sectorBytes, .in = in, .out = out, .len = len};
+    prince_xts_parallel(&job, threads);
+
+    return 0;
+}
+
+void prince_xts_init(princev2xts_t* xts, princev2key_t dataKey, princev2key_t tweakKey) {
+    assert(xts != NULL);
+
+    prince_ctx_init(&xts->data, dataKey);
+    prince_ctx_init(&xts->tweak, tweakKey);
+}
+
+int prince_xts_encrypt_sectors(const princev2xts_t* xts, uint64_t firstSector,
+                               size_t sectorBytes, const uint8_t* in, uint8_t* out,
+                               size_t len, int threads) {
+    return prince_xts_sectors(xts, ENC, firstSector, sectorBytes, in, out, len, threads);
+}
+
+int prince_xts_decrypt_sectors(const princev2xts_t* xts, uint64_t firstSector,
+                               size_t sectorBytes, const uint8_t* in, uint8_t* out,
+                               size_t len, int threads) {
+    return prince_xts_sectors(xts, DEC, firstSector, sectorBytes, in, out, len, threads);
+}
@@ -0,0 +1,59 @@
+/**
+princev2xts.h
+
+Interface for the XTS-like sector mode on top of PRINCEv2
+
+A buffer is cut into sectors of sectorBytes bytes (512 or 4096 for disks,
+any size of at least XTS_MIN_SECTOR_BYTES works), numbered on from
+firstSector. Block j of sector s, read most significant byte first, is
+encrypted as
+
+    C_j = E1(P_j ^ T_j) ^ T_j  with  T_j = E2(s) * x^j,
+
+E1 under the data key, E2 under the tweak key, and the product taken in
+GF(2^64) = GF(2)[x] / (x^64 + x^4 + x^3 + x + 1). The last sector of a
+buffer may be shorter. A sector whose length is not a multiple of 8 bytes
+ends with ciphertext stealing as in XTS: the last full block is encrypted
+with T_m, m being the number of full blocks, after taking the tail of the
+ciphertext of block m - 1 under T_{m - 1}, whose head becomes the partial
+last block. Ciphertext has the length of the plaintext.
+
+Sectors do not depend on each other, so any sector can be decrypted alone
+in time linear in its size, and long buffers are spread over threads.
+**/
+
+#ifndef _PRINCE_XTS_
+#define _PRINCE_XTS_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "princev2.h"
+
+enum {XTS_MIN_SECTOR_BYTES = sizeof(uint64_t)};
+
+/* more threads than this are cut down to it */
+enum {XTS_MAX_THREADS = 256};
+
+typedef struct xts {
+    princev2ctx_t data;
+    princev2ctx_t tweak;
+} princev2xts_t;
+
+/* expands the data and the tweak key once */
+void prince_xts_init(princev2xts_t* xts, princev2key_t dataKey, princev2key_t tweakKey);
+
+/* encrypts/decrypts len bytes from in to out as the sectors firstSector,
+   firstSector + 1, ... of sectorBytes bytes each. The last sector may be
+   shorter but not below XTS_MIN_SECTOR_BYTES. in and out may be the same
+   buffer. threads = 0 uses one thread per online CPU, at most
+   XTS_MAX_THREADS are used.
+   Returns 0 if no error */
+int prince_xts_encrypt_sectors(const princev2xts_t* xts, uint64_t firstSector,
+                               size_t sectorBytes, const uint8_t* in, uint8_t* out,
+                               size_t len, int threads);
+int prince_xts_decrypt_sectors(const princev2xts_t* xts, uint64_t firstSector,
+                               size_t sectorBytes, const uint8_t* in, uint8_t* out,
+                               size_t len, int threads);
+
+#endif
@@ -0,0 +1,127 @@
+/**
+prng.c
+
+Implementation of the seedable per-thread pseudorandom generator
+
+xoshiro256** and its jump polynomial follow the reference code at
+https://prng.di.unimi.it/. Per-thread generators are handed out from a
+global generator that is jumped once per thread, under a lock that is
+only taken on the first call of every thread.
+**/
+
+#include <assert.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "prng.h"
+
+static prng_t prng_global;
+static pthread_mutex_t prng_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* a thread's generator is valid while its generation matches the global one */
+static unsigned prng_generation = 1;
+static __thread prng_t prng_local;
+static __thread unsigned prng_localGeneration = 0;
+
+static inline uint64_t prng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t prng_splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+void prng_seed(prng_t* prng, uint64_t seed) {
+    assert(prng != NULL);
+
+    for (int i = 0; i < 4; i++) {
+        prng->s[i] = prng_splitmix64(&seed);
+    }
+}
+
+static inline uint64_t prng_step(uint64_t s[4]) {
+    uint64_t result = prng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = prng_rotl(s[3], 45);
+
+    return result;
+}
+
+uint64_t prng_next(prng_t* prng) {
+    return prng_step(prng->s);
+}
+
+void prng_fill(prng_t* prng, uint64_t* out, size_t n) {
+    /* keep the state in registers for the whole loop */
+    uint64_t s[4] = {prng->s[0], prng->s[1], prng->s[2], prng->s[3]};
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = prng_step(s);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        prng->s[i] = s[i];
+    }
+}
+
+void prng_jump(prng_t* prng) {
+    static const uint64_t jump[] = {
+        0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c
+    };
+    uint64_t s[4] = {0, 0, 0, 0};
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & ((uint64_t) 1 << b)) {
+                for (int j = 0; j < 4; j++) {
+                    s[j] ^= prng->s[j];
+                }
+            }
+            prng_step(prng->s);
+        }
+    }
+
+    for (int j = 0; j < 4; j++) {
+        prng->s[j] = s[j];
+    }
+}
+
+prng_t* prng_thread() {
+    if (prng_localGeneration != __atomic_load_n(&prng_generation, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&prng_lock);
+        prng_local = prng_global;
+        prng_jump(&prng_global);
+        prng_localGeneration = prng_generation;
+        pthread_mutex_unlock(&prng_lock);
+    }
+
+    return &prng_local;
+}
+
+void prng_seedThreads(uint64_t seed) {
+    pthread_mutex_lock(&prng_lock);
+    prng_seed(&prng_global, seed);
+    __atomic_store_n(&prng_generation, prng_generation + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&prng_lock);
+
+    prng_thread();
+}
+
+__attribute__((constructor))
+static void prng_init(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    prng_seed(&prng_global, ((uint64_t) ts.tv_sec << 30) ^ ts.tv_nsec ^
+                            ((uint64_t) getpid() << 48));
+}
@@ -0,0 +1,45 @@
+/**
+prng.h
+
+Interface for the seedable per-thread pseudorandom generator
+
+The generator is xoshiro256** by Blackman and Vigna: 256 bits of state,
+period 2^256 - 1, a few cycles per 64-bit output. A seed is expanded into
+the state with splitmix64. prng_jump advances a state by 2^128 outputs,
+so generators jumped a different number of times from the same seed
+produce disjoint substreams. Not suitable for keys that have to stay
+secret.
+**/
+
+#ifndef _PRNG_INCLUDED_
+#define _PRNG_INCLUDED_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+typedef struct prng {
+    uint64_t s[4];
+} prng_t;
+
+/* sets prng to the start of the stream for seed */
+void prng_seed(prng_t* prng, uint64_t seed);
+
+/* returns the next 64-bit output of prng */
+uint64_t prng_next(prng_t* prng);
+
+/* writes the next n outputs of prng to out */
+void prng_fill(prng_t* prng, uint64_t* out, size_t n);
+
+/* advances prng by 2^128 outputs */
+void prng_jump(prng_t* prng);
+
+/* returns the generator of the calling thread. Thread i (in order of their
+   first call) gets the stream of the global seed jumped i times */
+prng_t* prng_thread();
+
+/* restarts the per-thread streams from seed: the calling thread becomes
+   thread 0, the others move to new streams on their next call. Without it
+   the global seed is taken from the clock at startup */
+void prng_seedThreads(uint64_t seed);
+
+#endif